@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+    Created: 19 Oct 2026 6:31:57pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+#include <vector>
+
+/*
+ Compact plugin state: an 8 byte header (magic, version, record count) followed by one 8 byte record per parameter
+ (hash of the parameter ID, plain value). Everything is little endian.
+ Records are matched by ID rather than position, so parameters can be added or reordered in later versions, and
+ plain values are stored so a range change doesn't shift what a saved session sounds like.
+ Since version 2 a second count and list of records in the same layout follows, for the settings that aren't
+ parameters (so the host can't automate them) but still belong to the session.
+ Anything without the magic is treated as an older ValueTree state by the caller.
+ */
+namespace BinaryState
+{
+static constexpr char magic[4] = { 't', 'S', 'A', 'T' };
+static constexpr int currentVersion = 2;
+static constexpr int headerSize = 8;
+static constexpr int recordSize = 8;
+
+// FNV-1a over the UTF-8 ID, so it stays the same on every platform and JUCE version
+inline juce::uint32 hashParameterID (const juce::String& paramID)
+{
+    juce::uint32 hash = 2166136261u;
+    for (auto* c = paramID.toRawUTF8(); *c != 0; ++c)
+        hash = (hash ^ (juce::uint8)*c) * 16777619u;
+
+    return hash;
+}
+
+// non-parameter settings by name, read() only fills in the ones it finds
+using Settings = std::vector<std::pair<juce::String, float>>;
+
+inline bool isBinaryState (const void* data, int sizeInBytes)
+{
+    return sizeInBytes >= headerSize && std::memcmp(data, magic, sizeof(magic)) == 0;
+}
+
+inline void write (const juce::Array<juce::AudioProcessorParameter*>& parameters, const Settings& settings,
+                   juce::MemoryBlock& destData)
+{
+    destData.setSize(0);
+    destData.ensureSize((size_t)(headerSize + recordSize * parameters.size() + 2 + recordSize * (int)settings.size()));
+    juce::MemoryOutputStream stream(destData, false);
+
+    stream.write(magic, sizeof(magic));
+    stream.writeShort((short)currentVersion);
+    stream.writeShort((short)parameters.size());
+
+    for (auto* parameter : parameters)
+    {
+        auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+        jassert(ranged != nullptr);
+        stream.writeInt((int)hashParameterID(ranged->getParameterID()));
+        stream.writeFloat(ranged->convertFrom0to1(ranged->getValue()));
+    }
+
+    stream.writeShort((short)settings.size());
+    for (auto& setting : settings)
+    {
+        stream.writeInt((int)hashParameterID(setting.first));
+        stream.writeFloat(setting.second);
+    }
+}
+
+/*
+ Sets every parameter found in the state directly, and fills in the entries of settings that the state has.
+ Only parameters whose value actually changes notify their listeners. Those include the host's wrapper, so the host
+ is told about each changed value the same way as for an edit from the editor. Returns false if the data is unusable.
+ */
+inline bool read (const void* data, int sizeInBytes, const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                  Settings& settings)
+{
+    if (!isBinaryState(data, sizeInBytes))
+        return false;
+
+    juce::MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+    stream.skipNextBytes(sizeof(magic));
+    auto version = (int)(juce::uint16)stream.readShort();
+    auto numRecords = (int)(juce::uint16)stream.readShort();
+
+    if (version > currentVersion || sizeInBytes < headerSize + numRecords * recordSize)
+        return false;
+
+    for (int i = 0; i < numRecords; ++i)
+    {
+        auto idHash = (juce::uint32)stream.readInt();
+        auto plainValue = stream.readFloat();
+
+        for (auto* parameter : parameters)
+        {
+            auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+            if (ranged == nullptr || hashParameterID(ranged->getParameterID()) != idHash)
+                continue;
+
+            auto normalised = ranged->convertTo0to1(plainValue);
+            if (normalised != ranged->getValue())
+            {
+                ranged->setValue(normalised);
+                ranged->sendValueChangedMessageToListeners(normalised);
+            }
+            break;
+        }
+    }
+
+    if (version < 2 || stream.getNumBytesRemaining() < 2)
+        return true;
+
+    auto numSettings = (int)(juce::uint16)stream.readShort();
+    for (int i = 0; i < numSettings && stream.getNumBytesRemaining() >= recordSize; ++i)
+    {
+        auto idHash = (juce::uint32)stream.readInt();
+        auto value = stream.readFloat();
+
+        for (auto& setting : settings)
+            if (hashParameterID(setting.first) == idHash)
+                setting.second = value;
+    }
+
+    return true;
+}
+}
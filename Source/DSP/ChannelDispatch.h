@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    ChannelDispatch.h
+    Created: 19 Oct 2026 11:26:09am
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// 7.1.4 is the widest layout the plugin accepts
+static constexpr int maxSupportedChannels = 12;
+
+// kernels instantiated with this count read the channel count from the block at runtime instead
+static constexpr int dynamicChannelCount = 0;
+
+/*
+ Returns the number of channels a kernel loops over. For a fixed count this is a constant, so the channel loop can be unrolled.
+ */
+template <int NumChannels>
+inline int getKernelChannelCount (size_t runtimeChannels)
+{
+    if constexpr (NumChannels == dynamicChannelCount)
+    {
+        return (int)runtimeChannels;
+    }
+    else
+    {
+        jassert((int)runtimeChannels == NumChannels);
+        juce::ignoreUnused(runtimeChannels);
+        return NumChannels;
+    }
+}
+
+namespace ChannelDispatchDetail
+{
+template <typename Fn, int... Counts>
+void dispatch (int numChannels, Fn&& fn, std::integer_sequence<int, Counts...>)
+{
+    const bool handled = ((numChannels == Counts + 1 && (fn(std::integral_constant<int, Counts + 1>{}), true)) || ...);
+    
+    if (!handled)
+        fn(std::integral_constant<int, dynamicChannelCount>{});
+}
+}
+
+/*
+ Calls fn with a std::integral_constant holding the channel count, so every count from mono up to 7.1.4 gets its own
+ instantiation of whatever fn runs. Anything wider falls back to the runtime-count path.
+ */
+template <typename Fn>
+void dispatchChannelCount (int numChannels, Fn&& fn)
+{
+    ChannelDispatchDetail::dispatch(numChannels, std::forward<Fn>(fn), std::make_integer_sequence<int, maxSupportedChannels> {});
+}
+
+// used by the processors to explicitly instantiate their kernels for every channel count
+#define TSATURATOR_FOR_EACH_CHANNEL_COUNT(X) \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12)
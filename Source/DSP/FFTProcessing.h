@@ -14,90 +14,816 @@
 */
 
 #include "../GUI/Utilities.hpp"
+#include "SharedResources.h"
+#include "TripleBuffer.h"
+#include "OctaveFilterBank.h"
 #pragma once
 
 /*
  Takes incoming audio data and runs it through an FFT for the spectrum analyzer to display.
+ The audio thread only copies blocks into a lock-free ring. A low priority analysis thread drains the ring, runs the
+ FFTs and publishes finished scope frames through a triple buffer, which the GUI picks up whenever it repaints.
+ For the spectrogram every frame is also queued as a column, since one frame per repaint would tie its scroll speed
+ to the frame rate instead of the hop size.
+ The three sides never wait on each other, and if the analysis thread falls behind the ring simply drops samples.
+ FFT size, overlap and window can be changed at any time, the analysis thread picks them up before its next frame
+ and does any reallocating itself.
+ Instead of the FFT, the scope can also be filled from a 1/3 or 1/6 octave filterbank, which is far cheaper and
+ follows the low end much more closely in time, at the cost of resolution.
  */
 class FFTAnalyzer
 {
 public:
-    static constexpr int fftOrder = 11;
-    static constexpr int fftSize = 1 << fftOrder;
+    using WindowType = juce::dsp::WindowingFunction<float>::WindowingMethod;
+    using Ballistics = OctaveFilterBank::Ballistics;
+
+    enum class AnalysisMode { FFT, ThirdOctave, SixthOctave };
+
+    static constexpr int minFFTOrder = 10;
+    static constexpr int maxFFTOrder = 14;
+    static constexpr int automaticFFTOrder = 0;
+    static constexpr float maxOverlap = 0.875f;
     static constexpr int scopeSize = 2048;
     static constexpr int numChannels = 2;
+    static constexpr int ringSize = 16384;
+    static constexpr int spectrogramQueueSize = 64;    // frames, more than one idle repaint's worth at the smallest hop
+
+    struct ScopeFrame
+    {
+        float data[numChannels][scopeSize] = {};
+        float input[numChannels][scopeSize] = {};   // only filled while comparing the input
+        bool hasInput = false;
+    };
+
+    FFTAnalyzer() : thread(*this) {}
+
+    ~FFTAnalyzer() { stopAnalysis(); }
+
+    /*
+     Audio thread: copies a block of left/right samples in either precision into the ring, the analyzer itself always
+     works in float. Whatever doesn't fit is dropped. While no editor is showing the analyzer, or it is paused,
+     this is a single atomic load.
+     */
+    template <typename SampleType>
+    void pushSamples(const SampleType* left, const SampleType* right, int numSamples)
+    {
+        if (!tapEnabled.load())
+            return;
+
+        // registered before the flag is looked at again, so stopAnalysis() can't free the ring underneath this
+        tapUsers.fetch_add(1);
+        if (tapEnabled.load())
+        {
+            // with the input tap on, only as much output goes in as there is input next to it
+            if (pendingInputSamples >= 0)
+                numSamples = juce::jmin(numSamples, pendingInputSamples);
+
+            int start1, size1, start2, size2;
+            ring.prepareToWrite(numSamples, start1, size1, start2, size2);
+            copyIntoRing(buffers->ringData, left, right, start1, size1);
+            copyIntoRing(buffers->ringData, left + size1, right + size1, start2, size2);
+            ring.finishedWrite(size1 + size2);
+        }
+        tapUsers.fetch_sub(1);
+        pendingInputSamples = -1;
+    }
+
+    /*
+     Audio thread, before the block is processed: while the input is being compared, puts the dry samples next to
+     where the processed ones will go. Nothing is committed to the ring until pushSamples() follows with the output.
+     */
+    template <typename SampleType>
+    void pushInputSamples(const SampleType* left, const SampleType* right, int numSamples)
+    {
+        pendingInputSamples = -1;
+        if (!tapEnabled.load() || !comparingInput.load())
+            return;
+
+        tapUsers.fetch_add(1);
+        if (tapEnabled.load())
+        {
+            int start1, size1, start2, size2;
+            ring.prepareToWrite(numSamples, start1, size1, start2, size2);
+            copyIntoRing(buffers->inputRingData, left, right, start1, size1);
+            copyIntoRing(buffers->inputRingData, left + size1, right + size1, start2, size2);
+            pendingInputSamples = size1 + size2;
+        }
+        tapUsers.fetch_sub(1);
+    }
+
+    /*
+     With a frame decimation above 1, only every n-th frame is transformed. The frames that are skipped still
+     move the history along, so the ones that do get through are the same as without decimation.
+     */
+    void setFrameDecimation(int framesPerCapture) { frameDecimation.store(juce::jmax(1, framesPerCapture)); }
+
+    /*
+     The bin mapping and automatic FFT size follow the sample rate, both are updated before the next frame.
+     The latency is what the whole chain reports, the compared input is held back by that much to line up.
+     */
+    void prepare(double newSampleRate, int latencyInSamples)
+    {
+        sampleRate.store(newSampleRate);
+        inputLatency.store(juce::jmax(0, latencyInSamples));
+    }
+
+    // automaticFFTOrder picks the size from the sample rate, so the bin width stays about the same
+    void setFFTOrder(int order)
+    {
+        requestedOrder.store(order == automaticFFTOrder ? automaticFFTOrder : juce::jlimit(minFFTOrder, maxFFTOrder, order));
+    }
+
+    // what was asked for, so automaticFFTOrder rather than the order it resolved to
+    int getFFTOrder() const { return requestedOrder.load(); }
+
+    // fraction of each frame that is shared with the one before it
+    void setOverlap(float fraction) { overlap.store(juce::jlimit(0.0f, maxOverlap, fraction)); }
+    float getOverlap() const { return overlap.load(); }
+
+    void setWindowType(WindowType type) { windowType.store((int)type); }
+    WindowType getWindowType() const { return (WindowType)windowType.load(); }
+
+    void setAnalysisMode(AnalysisMode mode) { analysisMode.store((int)mode); }
+
+    // FFT mode only: also analyses the unprocessed input, in the same pass as the output
+    void setComparingInput(bool shouldCompare) { comparingInput.store(shouldCompare); }
+
+    // GUI: whether every published frame should also be queued as a spectrogram column
+    void setQueueingSpectrogram(bool shouldQueue)
+    {
+        // whatever is left over from the last time is stale
+        if (shouldQueue && buffers != nullptr)
+            buffers->columnQueue.finishedRead(buffers->columnQueue.getNumReady());
+
+        queueingSpectrogram.store(shouldQueue);
+    }
+
+    /*
+     GUI: calls column(levels) for every frame queued since the last call, oldest first, and returns how many there were.
+     levels has a value per scope point, the louder of the two channels mapped from MIN_DB..MAX_DB onto 0..255.
+     */
+    template <typename Function>
+    int readSpectrogramColumns(Function&& column)
+    {
+        if (buffers == nullptr)
+            return 0;
+
+        auto& queue = buffers->columnQueue;
+        int start1, size1, start2, size2;
+        queue.prepareToRead(queue.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            column(static_cast<const juce::uint8*>(buffers->columns[start1 + i]));
+        for (int i = 0; i < size2; ++i)
+            column(static_cast<const juce::uint8*>(buffers->columns[start2 + i]));
+
+        queue.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+    // only used by the filterbank modes, the FFT has its own smoothing
+    void setBallistics(Ballistics newBallistics) { ballistics.store((int)newBallistics); }
+    Ballistics getBallistics() const { return (Ballistics)ballistics.load(); }
+
+    // 2048 points at 44.1 or 48kHz, doubling with every doubling of the sample rate
+    static int getFFTOrderForSampleRate(double rate)
+    {
+        auto order = (int)std::round(std::log2(rate / referenceBinWidth));
+        return juce::jlimit(minFFTOrder, maxFFTOrder, order);
+    }
+
+    /*
+     Message thread: the analyzer's buffers only exist, and the analysis thread only runs, while an editor shows it.
+     */
+    void startAnalysis()
+    {
+        if (thread.isThreadRunning())
+            return;
+
+        buffers = std::make_unique<Buffers>();
+        ring.reset();
+        historyFill = 0;
+        framesUntilCapture = 0;
+        scopeHasHistory = false;
+        thread.startThread(juce::Thread::Priority::low);
+        updateTap();
+    }
+
+    void stopAnalysis()
+    {
+        tapEnabled.store(false);
+        while (tapUsers.load() != 0)
+            juce::Thread::yield();
+
+        thread.stopThread(1000);
+        releaseStorage();
+    }
+
+    // pausing keeps the last frame on screen, but the audio thread stops feeding the ring
+    void setPaused(bool shouldBePaused)
+    {
+        paused = shouldBePaused;
+        updateTap();
+    }
+
+    // GUI: swaps in the newest published frame, returns false if there wasn't one since the last call
+    bool pullLatestScope() { return buffers != nullptr && buffers->scopes.fetch(); }
+
+    const float* getScopeData(int channel) const
+    {
+        static const ScopeFrame empty;
+        return buffers != nullptr ? buffers->scopes.getReadBuffer().data[channel] : empty.data[channel];
+    }
+
+    // nullptr unless the latest frame came with the input compared
+    const float* getInputScopeData(int channel) const
+    {
+        if (buffers == nullptr || !buffers->scopes.getReadBuffer().hasInput)
+            return nullptr;
+
+        return buffers->scopes.getReadBuffer().input[channel];
+    }
+
+private:
+    struct AnalysisThread : juce::Thread
+    {
+        explicit AnalysisThread(FFTAnalyzer& a) : juce::Thread("tSaturator analysis"), analyzer(a) {}
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                analyzer.updateConfiguration();
+                analyzer.drainRing();
+                wait(analysisIntervalMs);
+            }
+        }
+
+        FFTAnalyzer& analyzer;
+    };
+
+    static constexpr int analysisIntervalMs = 10;
+    static constexpr double smoothingSeconds = 0.12;    // about what 0.7 per frame used to be at 48kHz
+    static constexpr double referenceBinWidth = 48000.0 / 2048.0;
+    static constexpr int referenceFFTSize = 2048;       // the display's dB range was tuned at this size
+
+    template <typename SampleType>
+    static void copyIntoRing(float (*destination)[ringSize], const SampleType* left, const SampleType* right, int start, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            std::memcpy(destination[0] + start, left, sizeof(float) * (size_t)numSamples);
+            std::memcpy(destination[1] + start, right, sizeof(float) * (size_t)numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                destination[0][start + i] = static_cast<float>(left[i]);
+                destination[1][start + i] = static_cast<float>(right[i]);
+            }
+        }
+    }
+
+    void updateTap() { tapEnabled.store(buffers != nullptr && !paused); }
+
+    // only called while the tap is off and the analysis thread is stopped
+    void releaseStorage()
+    {
+        buffers.reset();
+        for (auto& channelHistory : history)
+            std::vector<float>().swap(channelHistory);
+        std::vector<float>().swap(fftData);
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            std::vector<float>().swap(inputHistory[ch]);
+            std::vector<float>().swap(inputDelayLine[ch]);
+        }
+        std::vector<float>().swap(inputMagnitudes);
+        std::vector<std::complex<float>>().swap(packedPair);
+        std::vector<std::complex<float>>().swap(transformedPair);
+        comparing = false;
+        std::vector<int>().swap(pointFirstBin);
+        std::vector<int>().swap(pointTapStart);
+        std::vector<float>().swap(tapWeights);
+        forwardFFT.reset();
+        window.reset();
+        filterBank = OctaveFilterBank();
+        std::vector<int>().swap(pointBand);
+        std::vector<float>().swap(pointBandFraction);
+        fftOrder = 0;
+        fftSize = 0;
+        configuredWindowType = -1;
+        mappedFFTSize = 0;
+    }
+
+    // analysis thread from here on
+    void updateConfiguration()
+    {
+        auto rate = sampleRate.load();
+        auto order = requestedOrder.load();
+        if (order == automaticFFTOrder)
+            order = getFFTOrderForSampleRate(rate);
+
+        auto size = 1 << order;
+        auto type = windowType.load();
+        hopSize = juce::jmax(1, (int)std::round((float)size * (1.0f - overlap.load())));
+
+        if (order != fftOrder || type != configuredWindowType)
+        {
+            // the twiddles and window tables never change, so every instance using the same size reads the same copy
+            forwardFFT = SharedResources::get<juce::dsp::FFT>("fft/" + juce::String(order), [order]
+            {
+                return std::make_shared<const juce::dsp::FFT>(order);
+            });
+            window = SharedResources::get<juce::dsp::WindowingFunction<float>>("window/" + juce::String(type) + "/" + juce::String(size), [size, type]
+            {
+                return std::make_shared<const juce::dsp::WindowingFunction<float>>((size_t)size, (WindowType)type);
+            });
+            configuredWindowType = type;
+        }
+
+        if (order != fftOrder)
+        {
+            fftOrder = order;
+            fftSize = size;
+            fftData.assign((size_t)(2 * fftSize), 0.0f);
+            inputMagnitudes.assign((size_t)fftSize, 0.0f);
+            packedPair.assign((size_t)fftSize, {});
+            transformedPair.assign((size_t)fftSize, {});
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                history[ch].assign((size_t)fftSize, 0.0f);
+                inputHistory[ch].assign((size_t)fftSize, 0.0f);
+            }
+            historyFill = 0;
+        }
+
+        if (rate != mappedSampleRate || fftSize != mappedFFTSize)
+            buildBinMapping(rate);
+
+        auto mode = (AnalysisMode)analysisMode.load();
+        usingFilterBank = mode != AnalysisMode::FFT;
+        auto bandsPerOctave = mode == AnalysisMode::SixthOctave ? 6 : 3;
+
+        if (usingFilterBank && (bandsPerOctave != filterBank.getBandsPerOctave() || rate != filterBank.getSampleRate()))
+        {
+            filterBank.prepare(rate, bandsPerOctave, MIN_FREQ, MAX_FREQ);
+            buildBandMapping();
+        }
+
+        // the input starts from silence whenever the comparison starts or the latency moves
+        auto shouldCompare = comparingInput.load() && !usingFilterBank;
+        auto latency = inputLatency.load();
+        if (shouldCompare != comparing || (shouldCompare && latency != (int)inputDelayLine[0].size()))
+        {
+            comparing = shouldCompare;
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                inputDelayLine[ch].assign(comparing ? (size_t)latency : 0, 0.0f);
+                std::fill(inputHistory[ch].begin(), inputHistory[ch].end(), 0.0f);
+            }
+            inputDelayPosition = 0;
+            inputScopeHasHistory = false;
+        }
+    }
+
+    void drainRing()
+    {
+        int start1, size1, start2, size2;
+        ring.prepareToRead(ring.getNumReady(), start1, size1, start2, size2);
+
+        if (usingFilterBank)
+        {
+            filterBank.process(buffers->ringData[0] + start1, buffers->ringData[1] + start1, size1);
+            filterBank.process(buffers->ringData[0] + start2, buffers->ringData[1] + start2, size2);
+            if (size1 + size2 > 0)
+                publishFilterBankFrame();
+        }
+        else
+        {
+            consume(start1, size1);
+            consume(start2, size2);
+        }
+
+        ring.finishedRead(size1 + size2);
+    }
+
+    void consume(int start, int numSamples)
+    {
+        while (numSamples > 0)
+        {
+            auto toCopy = juce::jmin(numSamples, fftSize - historyFill);
+            for (int ch = 0; ch < numChannels; ++ch)
+                std::memcpy(history[ch].data() + historyFill, buffers->ringData[ch] + start, sizeof(float) * (size_t)toCopy);
 
-    FFTAnalyzer()
-        : forwardFFT(fftOrder),
-          window(fftSize, juce::dsp::WindowingFunction<float>::hann)
-    {}
+            if (comparing)
+                delayInput(start, toCopy);
+
+            historyFill += toCopy;
+            start += toCopy;
+            numSamples -= toCopy;
+
+            if (historyFill == fftSize)
+            {
+                auto framesPerCapture = frameDecimation.load();
+                if (--framesUntilCapture <= 0)
+                {
+                    processFrame(framesPerCapture);
+                    framesUntilCapture = framesPerCapture;
+                }
+
+                // keep the overlapping part as the start of the next frame
+                auto kept = fftSize - juce::jmin(hopSize, fftSize);
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    std::memmove(history[ch].data(), history[ch].data() + fftSize - kept, sizeof(float) * (size_t)kept);
+                    if (comparing)
+                        std::memmove(inputHistory[ch].data(), inputHistory[ch].data() + fftSize - kept, sizeof(float) * (size_t)kept);
+                }
+                historyFill = kept;
+            }
+        }
+    }
 
-    void pushSample(int channel, float sample)
+    // the compared input lags by the chain's latency, so each input frame lines up with the output frame it became
+    void delayInput(int start, int numSamples)
     {
-        jassert(channel < numChannels);
+        auto delayLength = (int)inputDelayLine[0].size();
+        auto position = inputDelayPosition;
 
-        if (fifoIndex[channel] == fftSize)
+        for (int ch = 0; ch < numChannels; ++ch)
         {
-            if (!nextFFTBlockReady[channel])
+            auto* source = buffers->inputRingData[ch] + start;
+            auto* destination = inputHistory[ch].data() + historyFill;
+
+            if (delayLength == 0)
             {
-                juce::zeromem(fftData[channel], sizeof(fftData[channel]));
-                memcpy(fftData[channel], fifo[channel], sizeof(fifo[channel]));
-                nextFFTBlockReady[channel] = true;
+                std::memcpy(destination, source, sizeof(float) * (size_t)numSamples);
+                continue;
             }
 
-            fifoIndex[channel] = 0;
+            auto* line = inputDelayLine[ch].data();
+            position = inputDelayPosition;
+            for (int i = 0; i < numSamples; ++i)
+            {
+                destination[i] = line[position];
+                line[position] = source[i];
+                if (++position == delayLength)
+                    position = 0;
+            }
         }
 
-        fifo[channel][fifoIndex[channel]++] = sample;
+        inputDelayPosition = position;
     }
 
-    void processFFT()
+    void processFrame(int framesPerCapture)
     {
-        constexpr float smoothingCoeff = 0.7f;
+        // the smoothing is defined as a time constant, so it looks the same whatever the frame rate is
+        auto frameSeconds = (double)(hopSize * framesPerCapture) / mappedSampleRate;
+        auto smoothingCoeff = scopeHasHistory ? (float)std::exp(-frameSeconds / smoothingSeconds) : 0.0f;
+        auto inputSmoothingCoeff = inputScopeHasHistory ? smoothingCoeff : 0.0f;
         
         for (int ch = 0; ch < numChannels; ++ch)
         {
-            if (!nextFFTBlockReady[ch]) continue;
+            if (comparing)
+            {
+                transformPair(history[ch].data(), inputHistory[ch].data());
+                updateScope(inputMagnitudes.data(), buffers->inputScopeData[ch], inputSmoothingCoeff);
+            }
+            else
+            {
+                std::copy(history[ch].begin(), history[ch].end(), fftData.begin());
 
-            window.multiplyWithWindowingTable(fftData[ch], fftSize);
-            forwardFFT.performFrequencyOnlyForwardTransform(fftData[ch]);
-            
-            int binWidth = 5;
+                window->multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+                forwardFFT->performRealOnlyForwardTransform(fftData.data(), true);
+                computeMagnitudes();
+            }
 
-            for (int i = 0; i < scopeSize; ++i)
+            updateScope(fftData.data(), buffers->scopeData[ch], smoothingCoeff);
+        }
+
+        scopeHasHistory = true;
+        inputScopeHasHistory = comparing;
+
+        auto& frame = buffers->scopes.getWriteBuffer();
+        memcpy(frame.data, buffers->scopeData, sizeof(buffers->scopeData));
+        if (comparing)
+            memcpy(frame.input, buffers->inputScopeData, sizeof(buffers->inputScopeData));
+        frame.hasInput = comparing;
+        queueSpectrogramColumn();
+        buffers->scopes.publish();
+    }
+
+    // a frame that doesn't fit is dropped, the GUI has fallen far enough behind that it won't miss one column
+    void queueSpectrogramColumn()
+    {
+        if (!queueingSpectrogram.load())
+            return;
+
+        int start1, size1, start2, size2;
+        buffers->columnQueue.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 == 0)
+            return;
+
+        auto* column = buffers->columns[start1];
+        const auto* left = buffers->scopeData[0];
+        const auto* right = buffers->scopeData[1];
+        constexpr float scale = 255.0f / (MAX_DB - MIN_DB);
+
+        for (int i = 0; i < scopeSize; ++i)
+            column[i] = (juce::uint8)juce::jlimit(0.0f, 255.0f, (juce::jmax(left[i], right[i]) - MIN_DB) * scale);
+
+        buffers->columnQueue.finishedWrite(1);
+    }
+
+    void updateScope(const float* magnitudes, float* scope, float smoothingCoeff)
+    {
+        mapBinsToScope(magnitudes, buffers->levels);
+        gainsToDecibels(buffers->levels, scopeSize);
+        juce::FloatVectorOperations::clip(buffers->levels, buffers->levels, MIN_DB, MAX_DB, scopeSize);
+
+        juce::FloatVectorOperations::multiply(scope, smoothingCoeff, scopeSize);
+        juce::FloatVectorOperations::addWithMultiply(scope, buffers->levels, 1.0f - smoothingCoeff, scopeSize);
+    }
+
+    /*
+     Two real frames through one complex FFT: the output goes in as the real part and the input as the imaginary part,
+     and the two spectra are pulled apart again by their symmetry. X[k] = (Z[k] + conj Z[N-k]) / 2 and
+     Y[k] = (Z[k] - conj Z[N-k]) / 2i. Leaves the output magnitudes in fftData and the input's in inputMagnitudes.
+     */
+    void transformPair(const float* output, const float* input)
+    {
+        std::copy(output, output + fftSize, fftData.begin());
+        std::copy(input, input + fftSize, inputMagnitudes.begin());
+        window->multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+        window->multiplyWithWindowingTable(inputMagnitudes.data(), (size_t)fftSize);
+
+        for (int i = 0; i < fftSize; ++i)
+            packedPair[(size_t)i] = { fftData[(size_t)i], inputMagnitudes[(size_t)i] };
+
+        forwardFFT->perform(packedPair.data(), transformedPair.data(), false);
+
+        for (int bin = 0; bin <= fftSize / 2; ++bin)
+        {
+            auto z = transformedPair[(size_t)bin];
+            auto mirrored = std::conj(transformedPair[(size_t)((fftSize - bin) & (fftSize - 1))]);
+            fftData[(size_t)bin] = 0.5f * std::abs(z + mirrored);
+            inputMagnitudes[(size_t)bin] = 0.5f * std::abs(z - mirrored);
+        }
+
+        // the taps padded past the last bin read these, with a weight of zero
+        std::fill(fftData.begin() + fftSize / 2 + 1, fftData.begin() + fftSize, 0.0f);
+        std::fill(inputMagnitudes.begin() + fftSize / 2 + 1, inputMagnitudes.end(), 0.0f);
+    }
+
+    // the real-only transform leaves interleaved re/im pairs for bins 0..N/2, the magnitudes go to the front in place
+    void computeMagnitudes()
+    {
+        auto* data = fftData.data();
+        for (int bin = 0; bin <= fftSize / 2; ++bin)
+        {
+            auto re = data[2 * bin];
+            auto im = data[2 * bin + 1];
+            data[bin] = std::sqrt(re * re + im * im);
+        }
+
+        // the taps padded past the last bin read these, with a weight of zero
+        std::fill(fftData.begin() + fftSize / 2 + 1, fftData.begin() + fftSize, 0.0f);
+    }
+
+    /*
+     Works out which bins every scope point averages, and how much each one counts. Scope points are spaced
+     logarithmically between MIN_FREQ and MAX_FREQ like the display draws them, and each one covers the span halfway
+     to its neighbours. Where that span is narrower than a bin it interpolates between the two nearest bins instead.
+     The taps of every point are padded to a multiple of four so the weighted sum can run four lanes at a time.
+     The weights also scale every size to the levels a 2048 point FFT shows, so the display's range holds for all of them.
+     */
+    void buildBinMapping(double rate)
+    {
+        auto numBins = fftSize / 2 + 1;
+        auto binsPerHz = (double)fftSize / rate;
+        auto octaveSpan = std::log2((double)MAX_FREQ / (double)MIN_FREQ);
+        auto halfStep = 0.5 * octaveSpan / (double)(scopeSize - 1);
+        auto levelScale = (double)referenceFFTSize / (double)fftSize;
+
+        pointFirstBin.resize(scopeSize);
+        pointTapStart.resize(scopeSize + 1);
+        tapWeights.clear();
+
+        for (int i = 0; i < scopeSize; ++i)
+        {
+            auto octaves = octaveSpan * (double)i / (double)(scopeSize - 1);
+            auto low = juce::jlimit(0.0, (double)(numBins - 1), MIN_FREQ * std::exp2(octaves - halfStep) * binsPerHz);
+            auto high = juce::jlimit(0.0, (double)(numBins - 1), MIN_FREQ * std::exp2(octaves + halfStep) * binsPerHz);
+
+            pointTapStart[(size_t)i] = (int)tapWeights.size();
+
+            if (high - low < 1.0)
+            {
+                auto centre = 0.5 * (low + high);
+                auto bin = juce::jmin((int)centre, numBins - 2);
+                auto frac = centre - bin;
+                pointFirstBin[(size_t)i] = bin;
+                tapWeights.push_back((float)((1.0 - frac) * levelScale));
+                tapWeights.push_back((float)(frac * levelScale));
+            }
+            else
             {
-                auto skewedX = 1.0f - std::exp(std::log(1.0f - (float)i / (float)scopeSize) * 0.2f);
-                int centerBin = juce::jlimit(0, fftSize / 2, (int)(skewedX * fftSize * 0.5f));
-                
-                float avgMagnitude = 0.0f;
-                int binCount = 0;
-                
-                for (int j = -binWidth; j <= binWidth; ++j)
+                // bin k is taken to cover [k - 0.5, k + 0.5), and counts for as much of that as lies inside the span
+                auto firstBin = (int)std::floor(low + 0.5);
+                auto lastBin = juce::jmin((int)std::floor(high + 0.5), numBins - 1);
+                auto width = high - low;
+                pointFirstBin[(size_t)i] = firstBin;
+
+                for (int k = firstBin; k <= lastBin; ++k)
                 {
-                    int bin = juce::jlimit(0, fftSize / 2, centerBin + j);
-                    avgMagnitude += fftData[ch][bin];
-                    ++binCount;
+                    auto overlapWithBin = juce::jmin(high, k + 0.5) - juce::jmax(low, k - 0.5);
+                    tapWeights.push_back((float)(juce::jmax(0.0, overlapWithBin) / width * levelScale));
                 }
-                
-                avgMagnitude /= (float)binCount;
-                auto levelInDB = juce::Decibels::gainToDecibels(fftData[ch][centerBin]);
-                levelInDB = juce::jlimit(MIN_DB, MAX_DB, levelInDB);
-                
-                if (scopeData[ch][i] == 0.0f)
-                    scopeData[ch][i] = levelInDB;
-                else
-                    scopeData[ch][i] = smoothingCoeff * scopeData[ch][i] + (1.0f - smoothingCoeff) * levelInDB;
             }
-            nextFFTBlockReady[ch] = false;
+
+            while ((tapWeights.size() - (size_t)pointTapStart[(size_t)i]) % 4 != 0)
+                tapWeights.push_back(0.0f);
         }
+
+        pointTapStart[(size_t)scopeSize] = (int)tapWeights.size();
+        mappedSampleRate = rate;
+        mappedFFTSize = fftSize;
     }
-    const float* getScopeData(int channel) const { return scopeData[channel]; }
-private:
-    juce::dsp::FFT forwardFFT;
-    juce::dsp::WindowingFunction<float> window;
-    float fifo[numChannels][fftSize] = {};
-    float fftData[numChannels][2 * fftSize] = {};
-    float scopeData[numChannels][scopeSize] = {};
-    int fifoIndex[numChannels] = {};
-    bool nextFFTBlockReady[numChannels] = {};
+
+    void mapBinsToScope(const float* magnitudes, float* destination) const
+    {
+        for (int i = 0; i < scopeSize; ++i)
+        {
+            auto* weights = tapWeights.data() + pointTapStart[(size_t)i];
+            auto* bins = magnitudes + pointFirstBin[(size_t)i];
+            auto numTaps = pointTapStart[(size_t)i + 1] - pointTapStart[(size_t)i];
+            float sum[4] = {};
+
+            for (int k = 0; k < numTaps; k += 4)
+                for (int lane = 0; lane < 4; ++lane)
+                    sum[lane] += weights[k + lane] * bins[k + lane];
+
+            destination[i] = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+        }
+    }
+
+    // scope points between two band centres interpolate their levels in dB, outside the bands they hold the end value
+    void buildBandMapping()
+    {
+        auto numBands = filterBank.getNumBands();
+        auto firstBand = filterBank.getBandFrequency(0);
+        auto octaveSpan = std::log2(MAX_FREQ / MIN_FREQ);
+
+        pointBand.resize(scopeSize);
+        pointBandFraction.resize(scopeSize);
+
+        for (int i = 0; i < scopeSize; ++i)
+        {
+            auto frequency = MIN_FREQ * std::exp2(octaveSpan * (float)i / (float)(scopeSize - 1));
+            auto position = juce::jlimit(0.0f, (float)(numBands - 1), std::log2(frequency / firstBand) * (float)filterBank.getBandsPerOctave());
+            auto band = juce::jmin((int)position, juce::jmax(0, numBands - 2));
+            pointBand[(size_t)i] = band;
+            pointBandFraction[(size_t)i] = numBands > 1 ? position - (float)band : 0.0f;
+        }
+    }
+
+    // the ballistics already smooth the bands, so this goes straight to the display
+    void publishFilterBankFrame()
+    {
+        filterBank.updateLevels((Ballistics)ballistics.load());
+
+        if (filterBank.getNumBands() == 0)
+            return;
+
+        // same scale as the FFT path, where a full scale sine reads as half the reference size
+        auto offset = juce::Decibels::gainToDecibels(0.5f * (float)referenceFFTSize);
+        auto hasNextBand = filterBank.getNumBands() > 1 ? 1 : 0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* bandLevels = filterBank.getLevels(ch);
+            auto* scope = buffers->scopeData[ch];
+
+            for (int i = 0; i < scopeSize; ++i)
+            {
+                auto band = pointBand[(size_t)i];
+                auto fraction = pointBandFraction[(size_t)i];
+                scope[i] = bandLevels[band] + fraction * (bandLevels[band + hasNextBand] - bandLevels[band]) + offset;
+            }
+
+            juce::FloatVectorOperations::clip(scope, scope, MIN_DB, MAX_DB, scopeSize);
+        }
+
+        scopeHasHistory = false;
+        memcpy(buffers->scopes.getWriteBuffer().data, buffers->scopeData, sizeof(buffers->scopeData));
+        queueSpectrogramColumn();
+        buffers->scopes.publish();
+    }
+
+    /*
+     20 * log10 with the exponent taken from the float's bits and the mantissa's log from a short atanh series,
+     good to about 0.002 dB. No calls and no branches, so the loop vectorises.
+     */
+    static void gainsToDecibels(float* data, int numValues)
+    {
+        constexpr float decibelsPerOctave = 6.0205999f;
+        constexpr float twoOverLn2 = 2.8853901f;
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            auto value = juce::jmax(data[i], 1.0e-5f);
+            juce::int32 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            auto exponent = (float)(((bits >> 23) & 0xff) - 127);
+            bits = (bits & 0x007fffff) | 0x3f800000;
+            float mantissa;
+            std::memcpy(&mantissa, &bits, sizeof(mantissa));
+
+            auto t = (mantissa - 1.0f) / (mantissa + 1.0f);
+            auto t2 = t * t;
+            auto log2Mantissa = twoOverLn2 * t * (1.0f + t2 * (1.0f / 3.0f + t2 * (1.0f / 5.0f)));
+
+            data[i] = decibelsPerOctave * (exponent + log2Mantissa);
+        }
+    }
+
+    // audio thread -> analysis thread
+    juce::AbstractFifo ring {ringSize};
+    std::atomic<bool> tapEnabled {false};
+    std::atomic<int> tapUsers {0};
+    int pendingInputSamples = -1;                   // audio thread only
+    std::atomic<int> frameDecimation {1};
+
+    // settings, read by the analysis thread before every batch of frames
+    std::atomic<double> sampleRate {44100.0};
+    std::atomic<int> requestedOrder {automaticFFTOrder};
+    std::atomic<float> overlap {0.5f};
+    std::atomic<int> windowType {(int)WindowType::hann};
+
+    // owned by the analysis thread
+    SharedResources::Ptr<juce::dsp::FFT> forwardFFT;
+    SharedResources::Ptr<juce::dsp::WindowingFunction<float>> window;
+    int fftOrder = 0;
+    int fftSize = 0;
+    int hopSize = 1;
+    int configuredWindowType = -1;
+    std::vector<float> history[numChannels];
+    std::vector<float> fftData;
+    int historyFill = 0;
+    int framesUntilCapture = 0;
+    bool scopeHasHistory = false;
+
+    // bin -> scope point mapping, rebuilt when the sample rate or FFT size changes
+    double mappedSampleRate = 0.0;
+    int mappedFFTSize = 0;
+    std::vector<int> pointFirstBin;
+    std::vector<int> pointTapStart;
+    std::vector<float> tapWeights;
+
+    // the filterbank modes, also owned by the analysis thread
+    std::atomic<int> analysisMode {(int)AnalysisMode::FFT};
+    std::atomic<int> ballistics {(int)Ballistics::Rms};
+    std::atomic<bool> queueingSpectrogram {false};
+
+    // the input comparison, also owned by the analysis thread
+    std::atomic<bool> comparingInput {false};
+    std::atomic<int> inputLatency {0};
+    bool comparing = false;
+    std::vector<float> inputHistory[numChannels];
+    std::vector<float> inputDelayLine[numChannels];
+    int inputDelayPosition = 0;
+    std::vector<float> inputMagnitudes;
+    std::vector<std::complex<float>> packedPair, transformedPair;
+    bool inputScopeHasHistory = false;
+    bool usingFilterBank = false;
+    OctaveFilterBank filterBank;
+    std::vector<int> pointBand;
+    std::vector<float> pointBandFraction;
+
+    /*
+     Everything sized by the scope or the ring, which is most of the analyzer's memory.
+     Allocated when an editor starts the analysis and freed when it stops.
+     */
+    struct Buffers
+    {
+        float ringData[numChannels][ringSize] = {};     // audio thread -> analysis thread
+        float inputRingData[numChannels][ringSize] = {};
+        float levels[scopeSize] = {};
+        float scopeData[numChannels][scopeSize] = {};
+        float inputScopeData[numChannels][scopeSize] = {};
+        TripleBuffer<ScopeFrame> scopes;                // analysis thread -> GUI
+        juce::uint8 columns[spectrogramQueueSize][scopeSize] = {};
+        juce::AbstractFifo columnQueue {spectrogramQueueSize};
+    };
+
+    std::unique_ptr<Buffers> buffers;
+    bool paused = false;
+
+    AnalysisThread thread;
 };
@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+    Created: 19 Oct 2026 8:47:12pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+/*
+ The 48 tap 4x interpolator from ITU-R BS.1770-4 annex 2, split into its four phases
+ */
+static constexpr float truePeakCoefficients[4][12] =
+{
+    {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+       0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+    { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+       0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+    { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+       0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+    { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+       0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+void LevelMeter::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, maximumBlockSize);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        converted[ch].assign((size_t)maxBlockSize, 0.0f);
+        truePeakInput[ch].assign((size_t)(truePeakTaps - 1 + maxBlockSize), 0.0f);
+        meanSquare[ch] = 0.0f;
+    }
+    truePeakPhase.assign((size_t)maxBlockSize, 0.0f);
+
+    // K-weighting as given in BS.1770, recomputed for the actual rate: a high shelf for the head, then the RLB high pass
+    {
+        auto k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+        auto q = 0.7071752369554196;
+        auto vh = std::pow(10.0, 3.999843853973347 / 20.0);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1.0 + k / q + k * k;
+
+        preFilter = {};
+        preFilter.b0 = (float)((vh + vb * k / q + k * k) / a0);
+        preFilter.b1 = (float)(2.0 * (k * k - vh) / a0);
+        preFilter.b2 = (float)((vh - vb * k / q + k * k) / a0);
+        preFilter.a1 = (float)(2.0 * (k * k - 1.0) / a0);
+        preFilter.a2 = (float)((1.0 - k / q + k * k) / a0);
+    }
+    {
+        auto k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+        auto q = 0.5003270373238773;
+        auto a0 = 1.0 + k / q + k * k;
+
+        rlbFilter = {};
+        rlbFilter.b0 = 1.0f;
+        rlbFilter.b1 = -2.0f;
+        rlbFilter.b2 = 1.0f;
+        rlbFilter.a1 = (float)(2.0 * (k * k - 1.0) / a0);
+        rlbFilter.a2 = (float)((1.0 - k / q + k * k) / a0);
+    }
+
+    samplesPerSubBlock = juce::roundToInt(sampleRate / 10.0);
+    subBlockEnergy = 0.0;
+    subBlockSamples = 0;
+    subBlocks.fill(0.0);
+    subBlockIndex = 0;
+    subBlocksSeen = 0;
+    gatedBlockCounts.fill(0);
+
+    for (int bin = 0; bin < histogramBins; ++bin)
+        histogramEnergies[(size_t)bin] = std::pow(10.0, ((double)getHistogramLoudness(bin) + 0.691) / 10.0);
+}
+
+void LevelMeter::processBlock(const float* left, const float* right, int numSamples, bool mono)
+{
+    if (numSamples <= 0)
+        return;
+
+    if (resetRequested.exchange(false))
+    {
+        gatedBlockCounts.fill(0);
+        readings.integratedLoudness.store(MeterReadings::minusInfinityDb);
+    }
+
+    // the editor resets the peaks when it takes them, so this only ever raises them. A plain load and store could
+    // miss a reset between the two and then leave the old peak in place, dropping this block's
+    auto raise = [](std::atomic<float>& value, float dB)
+    {
+        auto current = value.load();
+        while (dB > current && !value.compare_exchange_weak(current, dB)) {}
+    };
+
+    auto rmsCoeff = (float)std::exp(-(double)numSamples / (sampleRate * rmsSeconds));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* samples = ch == 0 ? left : right;
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+        auto peak = juce::jmax(-range.getStart(), range.getEnd());
+
+        auto blockMeanSquare = sumOfSquares(samples, numSamples) / (float)numSamples;
+        meanSquare[ch] = rmsCoeff * meanSquare[ch] + (1.0f - rmsCoeff) * blockMeanSquare;
+
+        // a true peak can't be lower than the samples it passes through
+        auto truePeak = juce::jmax(peak, measureTruePeak(ch, samples, numSamples));
+
+        raise(readings.samplePeak[(size_t)ch], juce::Decibels::gainToDecibels(peak, MeterReadings::minusInfinityDb));
+        raise(readings.truePeak[(size_t)ch], juce::Decibels::gainToDecibels(truePeak, MeterReadings::minusInfinityDb));
+        readings.rms[(size_t)ch].store(juce::Decibels::gainToDecibels(std::sqrt(meanSquare[ch]), MeterReadings::minusInfinityDb));
+    }
+
+    accumulateLoudness(left, right, numSamples, mono);
+}
+
+// four running sums instead of one, so the additions don't have to wait on each other and the loop vectorises
+float LevelMeter::sumOfSquares(const float* samples, int numSamples)
+{
+    float sums[4] = {};
+    int i = 0;
+
+    for (; i + 4 <= numSamples; i += 4)
+        for (int lane = 0; lane < 4; ++lane)
+            sums[lane] += samples[i + lane] * samples[i + lane];
+
+    for (; i < numSamples; ++i)
+        sums[0] += samples[i] * samples[i];
+
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+/*
+ Each phase of the interpolator is built up as twelve scaled, shifted copies of the block, all whole-block vector ops
+ */
+float LevelMeter::measureTruePeak(int channel, const float* samples, int numSamples)
+{
+    auto* input = truePeakInput[channel].data();
+    auto* phase = truePeakPhase.data();
+    std::memcpy(input + truePeakTaps - 1, samples, sizeof(float) * (size_t)numSamples);
+
+    float peak = 0.0f;
+
+    for (int p = 0; p < truePeakPhases; ++p)
+    {
+        juce::FloatVectorOperations::clear(phase, numSamples);
+        for (int k = 0; k < truePeakTaps; ++k)
+            juce::FloatVectorOperations::addWithMultiply(phase, input + truePeakTaps - 1 - k, truePeakCoefficients[p][k], numSamples);
+
+        auto range = juce::FloatVectorOperations::findMinAndMax(phase, numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+    }
+
+    // the end of this block is the history for the next one
+    std::memmove(input, input + numSamples, sizeof(float) * (size_t)(truePeakTaps - 1));
+    return peak;
+}
+
+void LevelMeter::accumulateLoudness(const float* left, const float* right, int numSamples, bool mono)
+{
+    if (mono)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto m = rlbFilter.process(preFilter.process(left[i], 0), 0);
+            subBlockEnergy += (double)(m * m);
+
+            if (++subBlockSamples == samplesPerSubBlock)
+                finishSubBlock();
+        }
+        return;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto l = rlbFilter.process(preFilter.process(left[i], 0), 0);
+        auto r = rlbFilter.process(preFilter.process(right[i], 1), 1);
+        subBlockEnergy += (double)(l * l + r * r);
+
+        if (++subBlockSamples == samplesPerSubBlock)
+            finishSubBlock();
+    }
+}
+
+/*
+ Every 100 ms: the last 400 ms make a gating block for the integrated loudness (so blocks overlap by 75%),
+ and the last 3 s make the short-term loudness. Gating blocks only go into a histogram, so the integrated loudness
+ can run for any length of time in fixed memory.
+ */
+void LevelMeter::finishSubBlock()
+{
+    subBlocks[(size_t)subBlockIndex] = subBlockEnergy / (double)samplesPerSubBlock;
+    subBlockIndex = (subBlockIndex + 1) % shortTermSubBlocks;
+    subBlocksSeen = juce::jmin(subBlocksSeen + 1, shortTermSubBlocks);
+    subBlockEnergy = 0.0;
+    subBlockSamples = 0;
+
+    auto averageOfLast = [this](int count)
+    {
+        double sum = 0.0;
+        for (int i = 1; i <= count; ++i)
+            sum += subBlocks[(size_t)((subBlockIndex - i + shortTermSubBlocks) % shortTermSubBlocks)];
+        return sum / (double)count;
+    };
+
+    if (subBlocksSeen >= gatingSubBlocks)
+    {
+        auto blockLoudness = energyToLoudness(averageOfLast(gatingSubBlocks));
+        if (blockLoudness > absoluteGate)
+        {
+            auto bin = juce::jlimit(0, histogramBins - 1, (int)((blockLoudness - absoluteGate) / histogramStep));
+            ++gatedBlockCounts[(size_t)bin];
+        }
+    }
+
+    readings.shortTermLoudness.store(energyToLoudness(averageOfLast(subBlocksSeen)));
+    readings.integratedLoudness.store(computeIntegratedLoudness());
+}
+
+float LevelMeter::computeIntegratedLoudness() const
+{
+    auto averageAbove = [this](float gate)
+    {
+        double energy = 0.0;
+        juce::uint64 count = 0;
+        for (int bin = 0; bin < histogramBins; ++bin)
+        {
+            auto n = gatedBlockCounts[(size_t)bin];
+            if (n == 0 || getHistogramLoudness(bin) < gate)
+                continue;
+
+            energy += histogramEnergies[(size_t)bin] * (double)n;
+            count += n;
+        }
+        return count > 0 ? energy / (double)count : 0.0;
+    };
+
+    auto ungated = averageAbove(absoluteGate);
+    if (ungated <= 0.0)
+        return MeterReadings::minusInfinityDb;
+
+    return energyToLoudness(averageAbove(energyToLoudness(ungated) + relativeGate));
+}
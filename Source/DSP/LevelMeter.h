@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+    Created: 19 Oct 2026 8:47:12pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+
+/*
+ What the editor reads from a meter. Every field is its own atomic, written once per block by the audio thread.
+ Peaks are the highest value since the editor last took them, so no peak between two repaints goes missing.
+ Everything is in dB (LUFS for the loudness values), silent meters read minusInfinityDb.
+ */
+struct MeterReadings
+{
+    static constexpr float minusInfinityDb = -100.0f;
+    static constexpr int numChannels = 2;
+
+    float takeSamplePeak (int channel) { return samplePeak[(size_t)channel].exchange(minusInfinityDb); }
+    float takeTruePeak (int channel) { return truePeak[(size_t)channel].exchange(minusInfinityDb); }
+    float getRms (int channel) const { return rms[(size_t)channel].load(); }
+    float getShortTermLoudness() const { return shortTermLoudness.load(); }
+    float getIntegratedLoudness() const { return integratedLoudness.load(); }
+
+    std::array<std::atomic<float>, numChannels> samplePeak { minusInfinityDb, minusInfinityDb };
+    std::array<std::atomic<float>, numChannels> truePeak { minusInfinityDb, minusInfinityDb };
+    std::array<std::atomic<float>, numChannels> rms { minusInfinityDb, minusInfinityDb };
+    std::atomic<float> shortTermLoudness { minusInfinityDb };
+    std::atomic<float> integratedLoudness { minusInfinityDb };
+};
+
+/*
+ Stereo level meter: sample peak, 300 ms RMS, 4x oversampled true peak and EBU R128 short-term and integrated loudness.
+ Everything is sized in prepare(), process() doesn't allocate or lock. The peak, RMS and true peak kernels run over
+ whole blocks so they vectorise, only the K-weighting filters go sample by sample.
+ */
+class LevelMeter
+{
+public:
+    static constexpr int numChannels = MeterReadings::numChannels;
+
+    void prepare (double sampleRate, int maximumBlockSize);
+
+    // mono buses pass the same pointer twice, blocks longer than the prepared size are split up
+    template <typename SampleType>
+    void process (const SampleType* left, const SampleType* right, int numSamples)
+    {
+        // BS.1770 sums the channels that are there, counting a mono channel twice would read 3 LU too loud
+        auto mono = left == right;
+
+        // nothing is sized before prepare()
+        jassert(maxBlockSize > 0);
+        if (maxBlockSize <= 0)
+            return;
+
+        for (int offset = 0; offset < numSamples; offset += maxBlockSize)
+        {
+            auto chunk = juce::jmin(maxBlockSize, numSamples - offset);
+
+            if constexpr (std::is_same_v<SampleType, float>)
+            {
+                processBlock(left + offset, right + offset, chunk, mono);
+            }
+            else
+            {
+                for (int i = 0; i < chunk; ++i)
+                {
+                    converted[0][(size_t)i] = static_cast<float>(left[offset + i]);
+                    converted[1][(size_t)i] = static_cast<float>(right[offset + i]);
+                }
+                processBlock(converted[0].data(), converted[1].data(), chunk, mono);
+            }
+        }
+    }
+
+    // the integrated loudness starts over at the next block
+    void resetIntegrated() { resetRequested.store(true); }
+
+    MeterReadings& getReadings() { return readings; }
+
+private:
+    static constexpr double rmsSeconds = 0.3;
+    static constexpr int truePeakTaps = 12;
+    static constexpr int truePeakPhases = 4;
+    static constexpr int gatingSubBlocks = 4;        // 400 ms momentary blocks, made of 100 ms steps
+    static constexpr int shortTermSubBlocks = 30;    // 3 s
+    static constexpr float absoluteGate = -70.0f;
+    static constexpr float relativeGate = -10.0f;
+    static constexpr int histogramBins = 1000;       // 0.1 LU steps from the absolute gate up
+    static constexpr float histogramStep = 0.1f;
+
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float s1[numChannels] = {}, s2[numChannels] = {};
+
+        float process (float x, int channel)
+        {
+            auto y = b0 * x + s1[channel];
+            s1[channel] = b1 * x - a1 * y + s2[channel];
+            s2[channel] = b2 * x - a2 * y;
+            return y;
+        }
+    };
+
+    void processBlock (const float* left, const float* right, int numSamples, bool mono);
+    float measureTruePeak (int channel, const float* samples, int numSamples);
+    void accumulateLoudness (const float* left, const float* right, int numSamples, bool mono);
+    void finishSubBlock();
+    float computeIntegratedLoudness() const;
+    static float sumOfSquares (const float* samples, int numSamples);
+    static float getHistogramLoudness (int bin) { return absoluteGate + ((float)bin + 0.5f) * histogramStep; }
+    static float energyToLoudness (double energy) { return energy > 0.0 ? (float)(-0.691 + 10.0 * std::log10(energy)) : MeterReadings::minusInfinityDb; }
+
+    MeterReadings readings;
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+    std::vector<float> converted[numChannels];
+
+    // RMS
+    float meanSquare[numChannels] = {};
+
+    // true peak: the last taps - 1 input samples followed by the block, and one interpolated phase at a time
+    std::vector<float> truePeakInput[numChannels];
+    std::vector<float> truePeakPhase;
+
+    // loudness
+    Biquad preFilter, rlbFilter;
+    double subBlockEnergy = 0.0;
+    int subBlockSamples = 0;
+    int samplesPerSubBlock = 4410;
+    std::array<double, shortTermSubBlocks> subBlocks {};
+    int subBlockIndex = 0;
+    int subBlocksSeen = 0;
+    std::array<juce::uint32, histogramBins> gatedBlockCounts {};
+    std::array<double, histogramBins> histogramEnergies {};
+    std::atomic<bool> resetRequested { false };
+};
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    OctaveFilterBank.cpp
+    Created: 19 Oct 2026 8:02:41pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#include "OctaveFilterBank.h"
+
+void OctaveFilterBank::Lanes::add(const juce::dsp::IIR::Coefficients<float>& coefficients)
+{
+    auto* c = coefficients.coefficients.begin();
+    b0.push_back(c[0]);
+    b1.push_back(c[1]);
+    b2.push_back(c[2]);
+    a1.push_back(c[3]);
+    a2.push_back(c[4]);
+    s1.push_back(0.0f);
+    s2.push_back(0.0f);
+}
+
+/*
+ Band centres are the usual base 2 series around 1kHz. A band goes into the fastest stage where it still sits above
+ an eighth of the stage's rate, so apart from the top stage every stage covers exactly one octave.
+ */
+void OctaveFilterBank::prepare(double newSampleRate, int newBandsPerOctave, float minFreq, float maxFreq)
+{
+    sampleRate = newSampleRate;
+    bandsPerOctave = newBandsPerOctave;
+    bandFrequencies.clear();
+    stages.clear();
+
+    auto topFreq = juce::jmin((double)maxFreq, 0.45 * sampleRate);
+    auto firstBand = (int)std::ceil(bandsPerOctave * std::log2(minFreq / 1000.0));
+    auto lastBand = (int)std::floor(bandsPerOctave * std::log2(topFreq / 1000.0));
+
+    auto bandwidth = std::exp2(1.0 / bandsPerOctave);
+    auto q = std::sqrt(bandwidth) / (bandwidth - 1.0);
+
+    for (int j = firstBand; j <= lastBand; ++j)
+    {
+        auto frequency = 1000.0 * std::exp2((double)j / bandsPerOctave);
+
+        size_t stageIndex = 0;
+        for (auto rate = sampleRate; frequency <= rate / 8.0; rate *= 0.5)
+            ++stageIndex;
+
+        while (stages.size() <= stageIndex)
+        {
+            stages.emplace_back();
+            stages.back().rate = sampleRate / (double)(1 << (stages.size() - 1));
+        }
+
+        auto& stage = stages[stageIndex];
+        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(stage.rate, (float)frequency, (float)q);
+        stage.bands.push_back((int)bandFrequencies.size());
+        for (int ch = 0; ch < numChannels; ++ch)
+            stage.bandFilters.add(*coefficients);
+
+        bandFrequencies.push_back((float)frequency);
+    }
+
+    // 6th order Butterworth at 0.2 of the stage's rate. Decimating folds everything above a quarter of the rate back
+    // around it: from there to about 0.43 of the rate (where it is only 17 dB down at the low end) the image lands
+    // above the next stage's bands, whose top edge is about 0.07 of this rate, and only their skirts keep it out.
+    // What would land inside those bands starts at 0.43 of the rate, where the low-pass is already about 95 dB down
+    constexpr float butterworthQs[numAntiAliasSections] = { 0.5176381f, 0.7071068f, 1.9318517f };
+
+    for (size_t k = 0; k < stages.size(); ++k)
+    {
+        auto& stage = stages[k];
+        stage.sumOfSquares.assign((size_t)stage.bandFilters.size(), 0.0f);
+        stage.peaks.assign((size_t)stage.bandFilters.size(), 0.0f);
+
+        if (k + 1 == stages.size())
+            continue;
+
+        for (auto sectionQ : butterworthQs)
+        {
+            auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(stage.rate, (float)(0.2 * stage.rate), sectionQ);
+            for (int ch = 0; ch < numChannels; ++ch)
+                stage.antiAlias.add(*coefficients);
+        }
+
+        for (auto& buffer : stage.decimated)
+            buffer.assign((size_t)(maxChunkSize / 2 + 1), 0.0f);
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        meanSquares[ch].assign(bandFrequencies.size(), 0.0f);
+        heldPeaks[ch].assign(bandFrequencies.size(), 0.0f);
+        levels[ch].assign(bandFrequencies.size(), -100.0f);
+    }
+}
+
+void OctaveFilterBank::process(const float* left, const float* right, int numSamples)
+{
+    if (stages.empty())
+        return;
+
+    for (int offset = 0; offset < numSamples; offset += maxChunkSize)
+    {
+        auto chunk = juce::jmin(maxChunkSize, numSamples - offset);
+        processStage(0, left + offset, right + offset, chunk);
+    }
+}
+
+void OctaveFilterBank::processStage(size_t stageIndex, const float* left, const float* right, int numSamples)
+{
+    auto& stage = stages[stageIndex];
+    auto numLanes = stage.bandFilters.size();
+    auto* b0 = stage.bandFilters.b0.data();
+    auto* b1 = stage.bandFilters.b1.data();
+    auto* b2 = stage.bandFilters.b2.data();
+    auto* a1 = stage.bandFilters.a1.data();
+    auto* a2 = stage.bandFilters.a2.data();
+    auto* s1 = stage.bandFilters.s1.data();
+    auto* s2 = stage.bandFilters.s2.data();
+    auto* sumOfSquares = stage.sumOfSquares.data();
+    auto* peaks = stage.peaks.data();
+    auto hasNextStage = stageIndex + 1 < stages.size();
+    int numDecimated = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float x[numChannels] = { left[i], right[i] };
+
+        // even lanes are the left channel, odd lanes the right
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto input = x[lane & 1];
+            auto y = b0[lane] * input + s1[lane];
+            s1[lane] = b1[lane] * input - a1[lane] * y + s2[lane];
+            s2[lane] = b2[lane] * input - a2[lane] * y;
+            sumOfSquares[lane] += y * y;
+            peaks[lane] = juce::jmax(peaks[lane], std::abs(y));
+        }
+
+        if (!hasNextStage)
+            continue;
+
+        auto& filter = stage.antiAlias;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int section = 0; section < numAntiAliasSections; ++section)
+            {
+                auto lane = (size_t)(section * numChannels + ch);
+                auto y = filter.b0[lane] * x[ch] + filter.s1[lane];
+                filter.s1[lane] = filter.b1[lane] * x[ch] - filter.a1[lane] * y + filter.s2[lane];
+                filter.s2[lane] = filter.b2[lane] * x[ch] - filter.a2[lane] * y;
+                x[ch] = y;
+            }
+        }
+
+        if (stage.keepNextSample)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                stage.decimated[ch][(size_t)numDecimated] = x[ch];
+            ++numDecimated;
+        }
+        stage.keepNextSample = !stage.keepNextSample;
+    }
+
+    stage.samplesSinceUpdate += numSamples;
+
+    if (numDecimated > 0)
+        processStage(stageIndex + 1, stage.decimated[0].data(), stage.decimated[1].data(), numDecimated);
+}
+
+/*
+ RMS levels integrate over rmsSeconds, peaks hold and fall back at peakDecayDbPerSecond. Both are expressed as the
+ amplitude of a sine with the same reading, so switching between them doesn't shift a steady tone.
+ */
+void OctaveFilterBank::updateLevels(Ballistics ballistics)
+{
+    for (auto& stage : stages)
+    {
+        if (stage.samplesSinceUpdate == 0)
+            continue;
+
+        auto seconds = stage.samplesSinceUpdate / stage.rate;
+        auto rmsCoeff = (float)std::exp(-seconds / rmsSeconds);
+        auto peakDecay = juce::Decibels::decibelsToGain(-peakDecayDbPerSecond * (float)seconds);
+
+        for (size_t i = 0; i < stage.bands.size(); ++i)
+        {
+            auto band = (size_t)stage.bands[i];
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto lane = i * numChannels + (size_t)ch;
+                auto blockMeanSquare = stage.sumOfSquares[lane] / (float)stage.samplesSinceUpdate;
+                meanSquares[ch][band] = rmsCoeff * meanSquares[ch][band] + (1.0f - rmsCoeff) * blockMeanSquare;
+                heldPeaks[ch][band] = juce::jmax(stage.peaks[lane], heldPeaks[ch][band] * peakDecay);
+                stage.sumOfSquares[lane] = 0.0f;
+                stage.peaks[lane] = 0.0f;
+            }
+        }
+
+        stage.samplesSinceUpdate = 0;
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        for (size_t band = 0; band < bandFrequencies.size(); ++band)
+        {
+            auto amplitude = ballistics == Ballistics::Rms ? std::sqrt(2.0f * meanSquares[ch][band]) : heldPeaks[ch][band];
+            levels[ch][band] = juce::Decibels::gainToDecibels(amplitude);
+        }
+    }
+}
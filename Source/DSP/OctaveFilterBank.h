@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    OctaveFilterBank.h
+    Created: 19 Oct 2026 8:02:41pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ Fractional octave band levels for the analyzer, from a bank of band-pass biquads.
+ Every octave runs at half the rate of the one above it: each stage low-passes and decimates its input for the next,
+ so the bands of one octave cost about as much as the octave above them. Within a stage all bands and both channels
+ are stored lane by lane, so the per-sample update is one loop over contiguous arrays that the compiler vectorises.
+ Not realtime safe to prepare, it's meant for the analysis thread.
+ */
+class OctaveFilterBank
+{
+public:
+    enum class Ballistics { Rms, Peak };
+
+    static constexpr int numChannels = 2;
+
+    void prepare (double sampleRate, int bandsPerOctave, float minFreq, float maxFreq);
+
+    // accumulates the band energy and peaks of a block, the levels only move on the next updateLevels()
+    void process (const float* left, const float* right, int numSamples);
+
+    // applies the ballistics to everything processed since the last call, levels are in dB relative to a full scale sine
+    void updateLevels (Ballistics ballistics);
+
+    int getNumBands() const { return (int)bandFrequencies.size(); }
+    int getBandsPerOctave() const { return bandsPerOctave; }
+    double getSampleRate() const { return sampleRate; }
+    float getBandFrequency (int band) const { return bandFrequencies[(size_t)band]; }
+    const float* getLevels (int channel) const { return levels[channel].data(); }
+
+private:
+    static constexpr double rmsSeconds = 0.1;
+    static constexpr float peakDecayDbPerSecond = 20.0f;
+    static constexpr int maxChunkSize = 512;
+    static constexpr int numAntiAliasSections = 3;
+
+    // biquads stored lane by lane (transposed direct form II)
+    struct Lanes
+    {
+        void add (const juce::dsp::IIR::Coefficients<float>& coefficients);
+        int size() const { return (int)b0.size(); }
+
+        std::vector<float> b0, b1, b2, a1, a2, s1, s2;
+    };
+
+    struct Stage
+    {
+        double rate = 0.0;
+        std::vector<int> bands;         // lane 2 * i + channel belongs to bands[i]
+        Lanes bandFilters;
+        std::vector<float> sumOfSquares, peaks;
+        int samplesSinceUpdate = 0;
+
+        Lanes antiAlias;                // numAntiAliasSections in series, one lane per channel
+        bool keepNextSample = true;
+        std::vector<float> decimated[numChannels];
+    };
+
+    void processStage (size_t stageIndex, const float* left, const float* right, int numSamples);
+
+    double sampleRate = 0.0;
+    int bandsPerOctave = 0;
+    std::vector<float> bandFrequencies;
+    std::vector<Stage> stages;
+    std::vector<float> meanSquares[numChannels];
+    std::vector<float> heldPeaks[numChannels];
+    std::vector<float> levels[numChannels];
+};
@@ -22,4 +22,6 @@ public:
     inline static juce::String DRIVE = "Drive";
     inline static juce::String MIX = "Mix";
     inline static juce::String HISS = "Hiss";
+    inline static juce::String DRIVE_POSITION = "Drive Position";
+    inline static juce::String HISS_POSITION = "Hiss Position";
 };
@@ -0,0 +1,536 @@
+/*
+  ==============================================================================
+
+    ProcessingGraph.h
+    Created: 19 Oct 2026 10:02:41am
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DriveProcessor.h"
+#include "SaturationProcessor.hpp"
+#include "HissProcessor.h"
+#include "MixProcessor.h"
+#include "ChannelDispatch.h"
+#include "QualityGovernor.h"
+#include "WorkerPool.h"
+
+/*
+ Every ordering of the wet stages that the user can pick from the Drive Position and Hiss Position parameters.
+ */
+enum class StageOrder
+{
+    DriveSaturationHiss,    // drive pre-curve, hiss post-saturation (the original order)
+    DriveHissSaturation,    // drive pre-curve, hiss pre-saturation
+    SaturationDriveHiss,    // drive post-curve, hiss post-saturation
+    HissSaturationDrive     // drive post-curve, hiss pre-saturation
+};
+
+inline StageOrder getStageOrder (bool drivePostCurve, bool hissPreSaturation)
+{
+    if (drivePostCurve)
+        return hissPreSaturation ? StageOrder::HissSaturationDrive : StageOrder::SaturationDriveHiss;
+    
+    return hissPreSaturation ? StageOrder::DriveHissSaturation : StageOrder::DriveSaturationHiss;
+}
+
+// bounds for the internal tile every stage works on, whatever size block the host hands us
+static constexpr int minTileSize = 32;
+static constexpr int maxTileSize = 128;
+static constexpr int defaultTileSize = 64;
+
+/*
+ Holds one of each processor for one sample type. Stages reach into it by member, so every call is resolved at compile time.
+ */
+template <typename SampleType>
+struct TapeChain
+{
+    using Context = juce::dsp::ProcessContextReplacing<SampleType>;
+    
+    TapeChain(juce::AudioProcessorValueTreeState& apvts) : dp(apvts), sp(apvts), hp(apvts), mp(apvts) {}
+    
+    /*
+     Sets the tile size used from the next prepare() on. Until then blocks keep being cut into the tiles
+     the stages were prepared for, since their buffers only fit those.
+     */
+    void setTileSize (int newTileSize)
+    {
+        pendingTileSize = juce::jlimit(minTileSize, maxTileSize, newTileSize);
+    }
+    
+    int getTileSize() const { return pendingTileSize; }
+    
+    /*
+     Sets whether the next prepare() sets up the pipelined mode, see processPipelined()
+     */
+    void setPipelined (bool shouldPipeline) { pipelined = shouldPipeline; }
+    
+    /*
+     Prepares every stage and returns the latency of the wet path, which the dry path has already been aligned to.
+     The stages are sized for one tile, not the host's block, so the working set stays the same at any buffer size.
+     Hosts call prepareToPlay far more often than the setup actually changes, so a repeat of the last
+     configuration only resets the stages' state and keeps everything that was allocated.
+     */
+    int prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        if (isPrepared
+            && spec.sampleRate == preparedSpec.sampleRate
+            && spec.numChannels == preparedSpec.numChannels
+            && pendingTileSize == preparedTileSize
+            && pipelined == preparedPipelined
+            && (!pipelined || spec.maximumBlockSize == preparedSpec.maximumBlockSize))
+        {
+            reset();
+            return latency;
+        }
+        
+        auto tileSpec = spec;
+        tileSpec.maximumBlockSize = (juce::uint32)pendingTileSize;
+        
+        dp.prepare(tileSpec);
+        sp.prepare(tileSpec);
+        hp.prepare(tileSpec);
+        
+        // the dry path is delayed by the oversampler latency so the mix stays phase aligned,
+        // plus a whole host block when the front of the chain runs a block ahead
+        pipelineDelay = pipelined ? (int)spec.maximumBlockSize : 0;
+        latency = juce::roundToInt(sp.getLatencyInSamples()) + pipelineDelay;
+        mp.setWetLatency(latency);
+        mp.prepare(tileSpec);
+        
+        pipelineInput.setSize((int)spec.numChannels, pipelineDelay, false, false, true);
+        pipelineRing.setSize((int)spec.numChannels, 2 * pipelineDelay, false, false, true);
+        pipelineInput.clear();
+        pipelineRing.clear();
+        pipelineOrders.assign((size_t)pipelineRing.getNumSamples(), StageOrder::DriveSaturationHiss);
+        pipelineWritePos = 0;
+        
+        preparedSpec = spec;
+        preparedTileSize = pendingTileSize;
+        preparedPipelined = pipelined;
+        isPrepared = true;
+        return latency;
+    }
+    
+    /*
+     Switches the stages' quality fallbacks on or off, each stage crossfades into its new setting by itself
+     */
+    void setQualityTier (QualityTier tier)
+    {
+        hp.setCheapHiss(tier >= QualityTier::CheapHiss);
+        sp.setReducedOversampling(tier >= QualityTier::ReducedOversampling);
+        sp.setApproximateCurve(tier >= QualityTier::ApproximateCurve);
+    }
+    
+    void reset()
+    {
+        dp.reset();
+        sp.reset();
+        hp.reset();
+        mp.reset();
+        pipelineRing.clear();
+        pipelineWritePos = 0;
+    }
+    
+    /*
+     Runs every stage over one tile at a time. The smoothed parameters keep their state between tiles,
+     so ramps carry on across tile and block boundaries.
+     */
+    template <typename Graph, int NumChannels>
+    void process (const Context& context)
+    {
+        forEachTile(context.getOutputBlock(), [&] (const Context& tileContext, size_t)
+        {
+            mp.template pushDryBlock<NumChannels>(tileContext.getInputBlock());
+            Graph::template process<NumChannels>(*this, tileContext);
+            mp.template process<NumChannels>(tileContext);
+        });
+    }
+    
+    void process (StageOrder order, const Context& context);
+    
+    /*
+     Pipelined mode: the front of the chain (every stage up to and including the saturation) runs on this block
+     on a worker, while the calling thread runs the back of the chain and the mix on the front's output from the
+     previous block. The two halves share no state, so they only meet once per block. Costs one extra host
+     block of latency, which prepare() has already added to the latency it returned.
+     The order the front used is kept alongside its output, so the back always finishes a stretch of audio with the
+     same order it was started with, and a change of order never runs a stage twice or skips one.
+     */
+    void processPipelined (StageOrder order, const Context& context, WorkerPool& pool);
+    
+    DriveProcessor<SampleType> dp;
+    SaturationProcessor<SampleType> sp;
+    HissProcessor<SampleType> hp;
+    MixProcessor<SampleType> mp;
+    
+private:
+    int pendingTileSize {defaultTileSize};
+    
+    // what the stages were last prepared for; the host's block size doesn't matter since the stages only see tiles
+    juce::dsp::ProcessSpec preparedSpec {};
+    int preparedTileSize {defaultTileSize};
+    int latency {0};
+    bool isPrepared {false};
+    bool preparedPipelined {false};
+    
+    // the front's output waits here for a block before the back picks it up
+    bool pipelined {false};
+    int pipelineDelay {0};
+    juce::AudioBuffer<SampleType> pipelineInput;
+    juce::AudioBuffer<SampleType> pipelineRing;
+    std::vector<StageOrder> pipelineOrders;     // per sample of pipelineRing, the order its front ran with
+    int pipelineWritePos {0};
+    
+    template <int NumChannels>
+    void processFront (StageOrder order, const juce::dsp::AudioBlock<SampleType>& frontBlock);
+    template <int NumChannels>
+    void processBack (const Context& context, int readPos);
+    
+    template <typename Function>
+    void forEachTile (const juce::dsp::AudioBlock<SampleType>& block, Function&& function)
+    {
+        auto numSamples = block.getNumSamples();
+        
+        for (size_t start = 0; start < numSamples; start += (size_t)preparedTileSize)
+        {
+            auto tile = block.getSubBlock(start, juce::jmin((size_t)preparedTileSize, numSamples - start));
+            Context tileContext(tile);
+            function(tileContext, start);
+        }
+    }
+    
+    // copies block into (or out of) the pipeline ring starting at ringPos, wrapping around its end
+    void copyRing (const juce::dsp::AudioBlock<SampleType>& block, int ringPos, bool intoRing)
+    {
+        auto numSamples = (int)block.getNumSamples();
+        auto firstPart = juce::jmin(numSamples, pipelineRing.getNumSamples() - ringPos);
+        
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* ring = pipelineRing.getWritePointer((int)ch);
+            auto* data = block.getChannelPointer(ch);
+            
+            if (intoRing)
+            {
+                juce::FloatVectorOperations::copy(ring + ringPos, data, firstPart);
+                juce::FloatVectorOperations::copy(ring, data + firstPart, numSamples - firstPart);
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy(data, ring + ringPos, firstPart);
+                juce::FloatVectorOperations::copy(data + firstPart, ring, numSamples - firstPart);
+            }
+        }
+    }
+};
+
+namespace Stages
+{
+struct Drive
+{
+    template <int NumChannels, typename Chain, typename Context>
+    static void process (Chain& chain, const Context& context) { chain.dp.template process<NumChannels>(context); }
+};
+
+struct Saturation
+{
+    template <int NumChannels, typename Chain, typename Context>
+    static void process (Chain& chain, const Context& context) { chain.sp.template process<NumChannels>(context); }
+};
+
+struct Hiss
+{
+    template <int NumChannels, typename Chain, typename Context>
+    static void process (Chain& chain, const Context& context) { chain.hp.template process<NumChannels>(context); }
+};
+}
+
+/*
+ A statically composed list of stages, run front to back. Each ordering is its own instantiation.
+ */
+template <typename... StageList>
+struct ProcessingGraph
+{
+    template <int NumChannels, typename Chain, typename Context>
+    static void process (Chain& chain, const Context& context)
+    {
+        (StageList::template process<NumChannels>(chain, context), ...);
+    }
+};
+
+using DriveSaturationHissGraph = ProcessingGraph<Stages::Drive, Stages::Saturation, Stages::Hiss>;
+using DriveHissSaturationGraph = ProcessingGraph<Stages::Drive, Stages::Hiss, Stages::Saturation>;
+using SaturationDriveHissGraph = ProcessingGraph<Stages::Saturation, Stages::Drive, Stages::Hiss>;
+using HissSaturationDriveGraph = ProcessingGraph<Stages::Hiss, Stages::Saturation, Stages::Drive>;
+
+/*
+ Each ordering cut in two after the saturation, for the pipelined mode
+ */
+template <StageOrder Order>
+struct PipelineSplit;
+
+template <>
+struct PipelineSplit<StageOrder::DriveSaturationHiss>
+{
+    using Front = ProcessingGraph<Stages::Drive, Stages::Saturation>;
+    using Back = ProcessingGraph<Stages::Hiss>;
+};
+
+template <>
+struct PipelineSplit<StageOrder::DriveHissSaturation>
+{
+    using Front = ProcessingGraph<Stages::Drive, Stages::Hiss, Stages::Saturation>;
+    using Back = ProcessingGraph<>;
+};
+
+template <>
+struct PipelineSplit<StageOrder::SaturationDriveHiss>
+{
+    using Front = ProcessingGraph<Stages::Saturation>;
+    using Back = ProcessingGraph<Stages::Drive, Stages::Hiss>;
+};
+
+template <>
+struct PipelineSplit<StageOrder::HissSaturationDrive>
+{
+    using Front = ProcessingGraph<Stages::Hiss, Stages::Saturation>;
+    using Back = ProcessingGraph<Stages::Drive>;
+};
+
+/*
+ Picks the graph and channel count instantiation once per block
+ */
+template <typename SampleType>
+inline void TapeChain<SampleType>::process (StageOrder order, const Context& context)
+{
+    dispatchChannelCount((int)context.getOutputBlock().getNumChannels(), [&] (auto channelCount)
+    {
+        constexpr int numChannels = decltype(channelCount)::value;
+        
+        switch (order)
+        {
+            case StageOrder::DriveSaturationHiss: this->template process<DriveSaturationHissGraph, numChannels>(context); break;
+            case StageOrder::DriveHissSaturation: this->template process<DriveHissSaturationGraph, numChannels>(context); break;
+            case StageOrder::SaturationDriveHiss: this->template process<SaturationDriveHissGraph, numChannels>(context); break;
+            case StageOrder::HissSaturationDrive: this->template process<HissSaturationDriveGraph, numChannels>(context); break;
+        }
+    });
+}
+
+/*
+ Calls function with a default constructed PipelineSplit for order, so the halves can be picked at run time
+ */
+template <typename Function>
+inline void withPipelineSplit (StageOrder order, Function&& function)
+{
+    switch (order)
+    {
+        case StageOrder::DriveSaturationHiss: function(PipelineSplit<StageOrder::DriveSaturationHiss>{}); break;
+        case StageOrder::DriveHissSaturation: function(PipelineSplit<StageOrder::DriveHissSaturation>{}); break;
+        case StageOrder::SaturationDriveHiss: function(PipelineSplit<StageOrder::SaturationDriveHiss>{}); break;
+        case StageOrder::HissSaturationDrive: function(PipelineSplit<StageOrder::HissSaturationDrive>{}); break;
+    }
+}
+
+/*
+ Same as process(), for the pipelined mode. The front takes this block's order, the back whichever order
+ each stretch of the ring was started with.
+ */
+template <typename SampleType>
+inline void TapeChain<SampleType>::processPipelined (StageOrder order, const Context& context, WorkerPool& pool)
+{
+    auto& block = context.getOutputBlock();
+    auto numSamples = (int)block.getNumSamples();
+    jassert(numSamples <= pipelineDelay);
+    
+    auto frontBlock = juce::dsp::AudioBlock<SampleType>(pipelineInput)
+                          .getSubsetChannelBlock(0, block.getNumChannels())
+                          .getSubBlock(0, (size_t)numSamples);
+    frontBlock.copyFrom(block);
+    
+    auto ringSize = pipelineRing.getNumSamples();
+    auto readPos = (pipelineWritePos + ringSize - pipelineDelay) % ringSize;
+    
+    dispatchChannelCount((int)block.getNumChannels(), [&] (auto channelCount)
+    {
+        constexpr int numChannels = decltype(channelCount)::value;
+        
+        auto job = [&] (int half)
+        {
+            if (half == 0)
+                this->template processFront<numChannels>(order, frontBlock);
+            else
+                this->template processBack<numChannels>(context, readPos);
+        };
+        pool.run(2, job);
+    });
+    
+    pipelineWritePos = (pipelineWritePos + numSamples) % ringSize;
+}
+
+template <typename SampleType>
+template <int NumChannels>
+inline void TapeChain<SampleType>::processFront (StageOrder order, const juce::dsp::AudioBlock<SampleType>& frontBlock)
+{
+    withPipelineSplit(order, [&] (auto split)
+    {
+        forEachTile(frontBlock, [&] (const Context& tileContext, size_t)
+        {
+            decltype(split)::Front::template process<NumChannels>(*this, tileContext);
+        });
+    });
+    
+    copyRing(frontBlock, pipelineWritePos, true);
+    
+    auto numSamples = (int)frontBlock.getNumSamples();
+    auto firstPart = juce::jmin(numSamples, (int)pipelineOrders.size() - pipelineWritePos);
+    std::fill_n(pipelineOrders.begin() + pipelineWritePos, firstPart, order);
+    std::fill_n(pipelineOrders.begin(), numSamples - firstPart, order);
+}
+
+/*
+ Orders almost never change, so a tile is nearly always one stretch, and a change splits the tile it lands in
+ */
+template <typename SampleType>
+template <int NumChannels>
+inline void TapeChain<SampleType>::processBack (const Context& context, int readPos)
+{
+    auto ringSize = (int)pipelineOrders.size();
+    
+    forEachTile(context.getOutputBlock(), [&] (const Context& tileContext, size_t start)
+    {
+        auto& tile = tileContext.getOutputBlock();
+        auto tilePos = (readPos + (int)start) % ringSize;
+        mp.template pushDryBlock<NumChannels>(tileContext.getInputBlock());
+        copyRing(tile, tilePos, false);
+        
+        auto tileLength = (int)tile.getNumSamples();
+        for (int spanStart = 0; spanStart < tileLength;)
+        {
+            auto order = pipelineOrders[(size_t)((tilePos + spanStart) % ringSize)];
+            auto spanEnd = spanStart + 1;
+            while (spanEnd < tileLength && pipelineOrders[(size_t)((tilePos + spanEnd) % ringSize)] == order)
+                ++spanEnd;
+            
+            auto span = tile.getSubBlock((size_t)spanStart, (size_t)(spanEnd - spanStart));
+            Context spanContext(span);
+            withPipelineSplit(order, [&] (auto split)
+            {
+                decltype(split)::Back::template process<NumChannels>(*this, spanContext);
+            });
+            spanStart = spanEnd;
+        }
+        
+        mp.template process<NumChannels>(tileContext);
+    });
+}
+
+/*
+ Splits a wide bus into channel groups, each with its own TapeChain (and so its own oversamplers, filters and noise),
+ and runs the groups on a WorkerPool. With no pool, or stereo and below, there is a single group run inline.
+ */
+template <typename SampleType>
+class GroupedTapeChain
+{
+public:
+    using Context = juce::dsp::ProcessContextReplacing<SampleType>;
+    
+    static constexpr int maxGroups = maxSupportedChannels / 2;
+    static constexpr int minChannelsPerGroup = 2;
+    
+    GroupedTapeChain(juce::AudioProcessorValueTreeState& apvtsRef) : apvts(apvtsRef)
+    {
+        chains.push_back(std::make_unique<TapeChain<SampleType>>(apvts));
+    }
+    
+    /*
+     Decides the channel groups for this bus and pool. Chains for extra groups are only ever added, never thrown away,
+     so going back to a configuration that was used before allocates nothing.
+     */
+    int prepare (const juce::dsp::ProcessSpec& spec, WorkerPool* workerPool)
+    {
+        pool = workerPool;
+        auto numChannels = (int)spec.numChannels;
+        numGroups = 1;
+        
+        // the pipeline already keeps the pool busy, so it runs the bus as one group
+        isPipelined = pipelineRequested && pool != nullptr;
+        chains.front()->setPipelined(isPipelined);
+        
+        if (pool != nullptr && !isPipelined && numChannels > minChannelsPerGroup)
+            numGroups = juce::jlimit(1, maxGroups, juce::jmin(pool->getNumWorkers() + 1, numChannels / minChannelsPerGroup));
+        
+        while ((int)chains.size() < numGroups)
+        {
+            chains.push_back(std::make_unique<TapeChain<SampleType>>(apvts));
+            chains.back()->setTileSize(chains.front()->getTileSize());
+        }
+        
+        int latency = 0;
+        for (int group = 0; group < numGroups; ++group)
+        {
+            groupStart[(size_t)group] = group * numChannels / numGroups;
+            groupSize[(size_t)group] = (group + 1) * numChannels / numGroups - groupStart[(size_t)group];
+            
+            auto groupSpec = spec;
+            groupSpec.numChannels = (juce::uint32)groupSize[(size_t)group];
+            latency = chains[(size_t)group]->prepare(groupSpec);
+        }
+        
+        return latency;
+    }
+    
+    void process (StageOrder order, const Context& context)
+    {
+        if (isPipelined)
+        {
+            chains.front()->processPipelined(order, context, *pool);
+            return;
+        }
+        
+        if (numGroups == 1)
+        {
+            chains.front()->process(order, context);
+            return;
+        }
+        
+        auto& block = context.getOutputBlock();
+        auto job = [&] (int group)
+        {
+            auto groupBlock = block.getSubsetChannelBlock((size_t)groupStart[(size_t)group], (size_t)groupSize[(size_t)group]);
+            Context groupContext(groupBlock);
+            chains[(size_t)group]->process(order, groupContext);
+        };
+        pool->run(numGroups, job);
+    }
+    
+    void setTileSize (int newTileSize)
+    {
+        for (auto& chain : chains)
+            chain->setTileSize(newTileSize);
+    }
+    
+    void setQualityTier (QualityTier tier)
+    {
+        for (auto& chain : chains)
+            chain->setQualityTier(tier);
+    }
+    
+    int getNumGroups() const { return numGroups; }
+    
+    // takes effect at the next prepare(), and only when there's a pool to run the front of the chain on
+    void setPipelined (bool shouldPipeline) { pipelineRequested = shouldPipeline; }
+    
+private:
+    juce::AudioProcessorValueTreeState& apvts;
+    std::vector<std::unique_ptr<TapeChain<SampleType>>> chains;
+    std::array<int, maxGroups> groupStart {}, groupSize {};
+    int numGroups {1};
+    WorkerPool* pool {nullptr};
+    bool pipelineRequested {false}, isPipelined {false};
+};
@@ -11,63 +11,71 @@
 #include "DriveProcessor.h"
 #include "Params.h"
 
-DriveProcessor::DriveProcessor(juce::AudioProcessorValueTreeState& apvts)
+template <typename SampleType>
+DriveProcessor<SampleType>::DriveProcessor(juce::AudioProcessorValueTreeState& apvts)
 {
     apvts.addParameterListener(Params::DRIVE, this);
+    parameterChanged(Params::DRIVE, apvts.getRawParameterValue(Params::DRIVE)->load());
 }
 
-void DriveProcessor::prepare (const juce::dsp::ProcessSpec& _spec)
+template <typename SampleType>
+void DriveProcessor<SampleType>::prepare (const juce::dsp::ProcessSpec& _spec)
 {
     spec = _spec;
-    prevGain = curGain;
-    if (drive == 0)
-    {
-        curGain = 0;
-    }
+    gain.reset(spec.sampleRate, parameterRampSeconds);
+    gain.setCurrentAndTargetValue((SampleType)targetGain.load());
+    gainRamp.ensureSize(spec.maximumBlockSize);
 }
 
-void DriveProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+template <typename SampleType>
+template <int NumChannels>
+void DriveProcessor<SampleType>::process (const juce::dsp::ProcessContextReplacing<SampleType>& context)
 {
     auto& block = context.getOutputBlock();
     auto numSamples = static_cast<int>(block.getNumSamples());
-    auto numChannels = static_cast<int>(block.getNumChannels());
+    auto numChannels = getKernelChannelCount<NumChannels>(block.getNumChannels());
+    jassert(numSamples <= (int)spec.maximumBlockSize);
     
-    if (curGain != prevGain)
+    gain.setTargetValue((SampleType)targetGain.load());
+    
+    // the ramp is shared by every channel, so the smoother only advances once per tile
+    if (fillParameterRamp(gain, gainRamp.get(), numSamples))
     {
         for (int ch = 0; ch < numChannels; ++ch)
-            {
-                float* channelData = block.getChannelPointer(ch);
-                float gainStep = (curGain - prevGain) / numSamples;
-                float gain = prevGain;
-
-                for (int i = 0; i < numSamples; ++i)
-                {
-                    channelData[i] *= gain;
-                    gain += gainStep;
-                }
-            }
-        prevGain = curGain;
+        {
+            juce::FloatVectorOperations::multiply(block.getChannelPointer(ch), gainRamp.get(), numSamples);
+        }
     }
     else
     {
         for (int ch = 0; ch < numChannels; ++ch)
         {
-            juce::FloatVectorOperations::multiply(block.getChannelPointer(ch), curGain, numSamples);
+            juce::FloatVectorOperations::multiply(block.getChannelPointer(ch), gain.getTargetValue(), numSamples);
         }
     }
 }
 
-void DriveProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+template <typename SampleType>
+void DriveProcessor<SampleType>::parameterChanged (const juce::String& parameterID, float newValue)
 {
     if (parameterID == Params::DRIVE)
     {
         drive = newValue;
-        prevGain = curGain;
         mapDriveScaleToDecibels(drive);
     }
 }
 
-void DriveProcessor::reset()
+template <typename SampleType>
+void DriveProcessor<SampleType>::reset()
 {
-    prevGain = curGain;
+    gain.setCurrentAndTargetValue((SampleType)targetGain.load());
 }
+
+template class DriveProcessor<float>;
+template class DriveProcessor<double>;
+
+#define TSATURATOR_INSTANTIATE_DRIVE(n) \
+    template void DriveProcessor<float>::process<n> (const juce::dsp::ProcessContextReplacing<float>&); \
+    template void DriveProcessor<double>::process<n> (const juce::dsp::ProcessContextReplacing<double>&);
+TSATURATOR_FOR_EACH_CHANNEL_COUNT(TSATURATOR_INSTANTIATE_DRIVE)
+#undef TSATURATOR_INSTANTIATE_DRIVE
@@ -12,11 +12,14 @@
 
 #include <JuceHeader.h>
 #include "Params.h"
+#include "ChannelDispatch.h"
+#include "Smoothing.h"
 
 /*
  Handles applying gain to the incoming signal before saturation is applied.
  */
-class DriveProcessor : public juce::dsp::ProcessorBase, public juce::AudioProcessorValueTreeState::Listener
+template <typename SampleType>
+class DriveProcessor final : public juce::AudioProcessorValueTreeState::Listener
 {
 public:
     DriveProcessor(juce::AudioProcessorValueTreeState& apvts);
@@ -24,18 +27,22 @@ public:
     inline void mapDriveScaleToDecibels(float drive)
     {
         float gainInDecibels = juce::jmap(drive, 0.0f, 10.0f, 0.0f, 12.0f); // 0dB to +12dB range
-        curGain = juce::Decibels::decibelsToGain(gainInDecibels);
+        targetGain.store(juce::Decibels::decibelsToGain(gainInDecibels));
     }
-    void prepare (const juce::dsp::ProcessSpec& _spec) override;
-    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
-    void reset () override;
+    void prepare (const juce::dsp::ProcessSpec& _spec);
+    template <int NumChannels = dynamicChannelCount>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context);
+    void reset ();
     void parameterChanged (const juce::String& parameterID, float newValue) override;
 private:
     juce::AudioProcessorValueTreeState* apvts;
     juce::dsp::ProcessSpec spec;
     float drive;
-    float curGain;
-    float prevGain;
+    
+    // written by the parameter listener, picked up by the smoother at the start of each tile
+    std::atomic<float> targetGain {1.f};
+    juce::SmoothedValue<SampleType> gain;
+    ParameterRampBuffer<SampleType> gainRamp;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DriveProcessor)
 };
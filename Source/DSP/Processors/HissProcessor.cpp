@@ -10,128 +10,276 @@
 
 #include "HissProcessor.h"
 #include "Params.h"
+#include "TableCache.h"
 
 /*
  Sets the gain value for the amount of hiss heard based on the knob value, scaled between -60dB and -12dB.
  */
-void HissProcessor::setGain(float hissPercentage)
+template <typename SampleType>
+void HissProcessor<SampleType>::setGain(float hissPercentage)
 {
-    float targetGain = juce::Decibels::decibelsToGain(juce::jmap(hissPercentage, 0.0f, 100.0f, -60.0f, -12.0f));
-    curGain = targetGain;
+    targetGain.store(juce::Decibels::decibelsToGain(juce::jmap(hissPercentage, 0.0f, 100.0f, -60.0f, -12.0f)));
 }
 
 /*
  Sets (and returns) the coefficients for a peak filter in the EQ
  */
-FilterPtr peakFilter(float freq, float q, float gain, double sampleRate)
+template <typename SampleType>
+FilterPtr<SampleType> peakFilter(float freq, float q, float gain, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, freq, q, juce::Decibels::decibelsToGain(gain));
+    return juce::dsp::IIR::Coefficients<SampleType>::makePeakFilter(sampleRate, freq, q, juce::Decibels::decibelsToGain(gain));
 }
 
 /*
  Sets (and returns) the coefficients for a low cut filter in the EQ
  */
-FilterPtr lowCutFilter(const HissResponseCurveSettings& settings, double sampleRate)
+template <typename SampleType>
+FilterPtr<SampleType> lowCutFilter(const HissResponseCurveSettings& settings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, settings.lowCutFreq);
+    return juce::dsp::IIR::Coefficients<SampleType>::makeHighPass(sampleRate, settings.lowCutFreq);
 }
 
 /*
  Sets (and returns) the coefficients for a high cut filter in the EQ
  */
-FilterPtr highCutFilter(const HissResponseCurveSettings& settings, double sampleRate)
+template <typename SampleType>
+FilterPtr<SampleType> highCutFilter(const HissResponseCurveSettings& settings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, settings.highCutFreq);
+    return juce::dsp::IIR::Coefficients<SampleType>::makeLowPass(sampleRate, settings.highCutFreq);
 }
 
 /*
  Sets (and returns) the coefficients for a low shelf filter in the EQ
  */
-FilterPtr lowShelfFilter(const HissResponseCurveSettings& settings, double sampleRate)
+template <typename SampleType>
+FilterPtr<SampleType> lowShelfFilter(const HissResponseCurveSettings& settings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, settings.lowShelfFreq, settings.lowShelfQuality, juce::Decibels::decibelsToGain(settings.lowShelfGainDecibels));
+    return juce::dsp::IIR::Coefficients<SampleType>::makeLowShelf(sampleRate, settings.lowShelfFreq, settings.lowShelfQuality, juce::Decibels::decibelsToGain(settings.lowShelfGainDecibels));
 }
 
 /*
  Sets (and returns) the coefficients for a high shelf filter in the EQ
  */
-FilterPtr highShelfFilter(const HissResponseCurveSettings& settings, double sampleRate)
+template <typename SampleType>
+FilterPtr<SampleType> highShelfFilter(const HissResponseCurveSettings& settings, double sampleRate)
 {
-    return juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, settings.highShelfFreq, settings.highShelfQuality, juce::Decibels::decibelsToGain(settings.highShelfGainDecibels));
+    return juce::dsp::IIR::Coefficients<SampleType>::makeHighShelf(sampleRate, settings.highShelfFreq, settings.highShelfQuality, juce::Decibels::decibelsToGain(settings.highShelfGainDecibels));
 }
 
 /*
- Instantiates all filters in the EQ with the proper coefficients
+ Builds the coefficients for every band of the EQ. A band with no frequency set is left flat.
+ The designs are kept in the on-disk table cache as five normalised biquad coefficients per band,
+ so after the first load they are only read back.
  */
-void HissProcessor::initializeFilters(HissResponseCurveSettings& hrcs)
+template <typename SampleType>
+std::shared_ptr<const HissEQCoefficients<SampleType>> makeHissEQCoefficients(const HissResponseCurveSettings& hrcs, double sampleRate, const juce::String& key)
 {
-    updateCoefficients(preProcessEQ.get<LOW_CUT>(), lowCutFilter(hrcs, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<LOW_SHELF>(), lowShelfFilter(hrcs, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<BAND_ONE>(), peakFilter(hrcs.bandOneFreq, hrcs.bandOneQuality, hrcs.bandOneGainDecibels, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<BAND_TWO>(), peakFilter(hrcs.bandTwoFreq, hrcs.bandTwoQuality, hrcs.bandTwoGainDecibels, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<BAND_THREE>(), peakFilter(hrcs.bandThreeFreq, hrcs.bandThreeQuality, hrcs.bandThreeGainDecibels, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<BAND_FOUR>(), peakFilter(hrcs.bandFourFreq, hrcs.bandFourQuality, hrcs.bandFourGainDecibels, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<HIGH_SHELF>(), highShelfFilter(hrcs, spec.sampleRate));
-    updateCoefficients(preProcessEQ.get<HIGH_CUT>(), highCutFilter(hrcs, spec.sampleRate));
+    constexpr size_t coefficientsPerBand = 5;
+    
+    auto bank = TableCache::load<SampleType>(key, [&]
+    {
+        auto flat = [] { return FilterPtr<SampleType>(new juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0)); };
+        
+        std::array<FilterPtr<SampleType>, HIGH_CUT + 1> designs;
+        designs[LOW_CUT] = hrcs.lowCutFreq > 0 ? lowCutFilter<SampleType>(hrcs, sampleRate) : flat();
+        designs[LOW_SHELF] = hrcs.lowShelfFreq > 0 ? lowShelfFilter<SampleType>(hrcs, sampleRate) : flat();
+        designs[BAND_ONE] = peakFilter<SampleType>(hrcs.bandOneFreq, hrcs.bandOneQuality, hrcs.bandOneGainDecibels, sampleRate);
+        designs[BAND_TWO] = peakFilter<SampleType>(hrcs.bandTwoFreq, hrcs.bandTwoQuality, hrcs.bandTwoGainDecibels, sampleRate);
+        designs[BAND_THREE] = peakFilter<SampleType>(hrcs.bandThreeFreq, hrcs.bandThreeQuality, hrcs.bandThreeGainDecibels, sampleRate);
+        designs[BAND_FOUR] = peakFilter<SampleType>(hrcs.bandFourFreq, hrcs.bandFourQuality, hrcs.bandFourGainDecibels, sampleRate);
+        designs[HIGH_SHELF] = hrcs.highShelfFreq > 0 ? highShelfFilter<SampleType>(hrcs, sampleRate) : flat();
+        designs[HIGH_CUT] = hrcs.highCutFreq > 0 ? highCutFilter<SampleType>(hrcs, sampleRate) : flat();
+        
+        std::vector<SampleType> values;
+        for (auto& design : designs)
+        {
+            jassert((size_t)design->coefficients.size() == coefficientsPerBand);
+            for (auto c : design->coefficients)
+                values.push_back(c);
+        }
+        return values;
+    });
+    
+    auto coefficients = std::make_shared<HissEQCoefficients<SampleType>>();
+    jassert(bank->size() == coefficients->bands.size() * coefficientsPerBand);
+    
+    for (size_t band = 0; band < coefficients->bands.size(); ++band)
+    {
+        auto* c = bank->data() + band * coefficientsPerBand;
+        coefficients->bands[band] = new juce::dsp::IIR::Coefficients<SampleType>(c[0], c[1], c[2], 1, c[3], c[4]);
+    }
+    
+    return coefficients;
 }
 
-HissProcessor::HissProcessor(juce::AudioProcessorValueTreeState& apvts)
+/*
+ Points all filters in the EQ at the shared coefficients for this sample rate, building them if no other instance has
+ */
+template <typename SampleType>
+void HissProcessor<SampleType>::initializeFilters(const HissResponseCurveSettings& hrcs)
+{
+    auto key = "hissEQ/" + juce::String(8 * (int)sizeof(SampleType)) + "/" + juce::String(spec.sampleRate) + "/" + SharedResources::describe(hrcs);
+    eqCoefficients = SharedResources::get<HissEQCoefficients<SampleType>>(key, [&]
+    {
+        return makeHissEQCoefficients<SampleType>(hrcs, spec.sampleRate, key);
+    });
+    
+    for (auto& eq : preProcessEQ)
+    {
+        updateCoefficients(eq.template get<LOW_CUT>(), eqCoefficients->bands[LOW_CUT]);
+        updateCoefficients(eq.template get<LOW_SHELF>(), eqCoefficients->bands[LOW_SHELF]);
+        updateCoefficients(eq.template get<BAND_ONE>(), eqCoefficients->bands[BAND_ONE]);
+        updateCoefficients(eq.template get<BAND_TWO>(), eqCoefficients->bands[BAND_TWO]);
+        updateCoefficients(eq.template get<BAND_THREE>(), eqCoefficients->bands[BAND_THREE]);
+        updateCoefficients(eq.template get<BAND_FOUR>(), eqCoefficients->bands[BAND_FOUR]);
+        updateCoefficients(eq.template get<HIGH_SHELF>(), eqCoefficients->bands[HIGH_SHELF]);
+        updateCoefficients(eq.template get<HIGH_CUT>(), eqCoefficients->bands[HIGH_CUT]);
+    }
+    
+    for (auto& filter : cheapEQ)
+        updateCoefficients(filter, eqCoefficients->bands[LOW_CUT]);
+}
+
+template <typename SampleType>
+HissProcessor<SampleType>::HissProcessor(juce::AudioProcessorValueTreeState& apvts)
 {
     apvts.addParameterListener(Params::HISS, this);
+    parameterChanged(Params::HISS, apvts.getRawParameterValue(Params::HISS)->load());
 }
 
-void HissProcessor::prepare (const juce::dsp::ProcessSpec& _spec)
+template <typename SampleType>
+void HissProcessor<SampleType>::prepare (const juce::dsp::ProcessSpec& _spec)
 {
     spec = _spec;
-    prevGain = curGain = juce::Decibels::decibelsToGain(-60.f);
-    preProcessEQ.prepare(spec);
+    gain.reset(spec.sampleRate, parameterRampSeconds);
+    gain.setCurrentAndTargetValue((SampleType)targetGain.load());
+    gainRamp.ensureSize(spec.maximumBlockSize);
+    
+    // each EQ chain only ever sees one channel
+    auto channelSpec = spec;
+    channelSpec.numChannels = 1;
+    for (size_t ch = 0; ch < spec.numChannels; ++ch)
+    {
+        preProcessEQ[ch].prepare(channelSpec);
+        cheapEQ[ch].prepare(channelSpec);
+    }
+    initializeFilters(settings);
+    
+    noiseBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize, false, false, true);
+    cheapNoiseBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize, false, false, true);
+    
+    cheapBlend.reset(spec.sampleRate, qualityFadeSeconds);
+    cheapBlend.setCurrentAndTargetValue(cheapHiss.load() ? 1 : 0);
+    cheapBlendRamp.ensureSize(spec.maximumBlockSize);
+    fullPathActive = cheapPathActive = false;
 }
 
 /*
  Generates white noise
  */
-void HissProcessor::processBlock(float *buffer, int numSamples)
+template <typename SampleType>
+void HissProcessor<SampleType>::processBlock(SampleType *buffer, int numSamples)
 {
     for (int n = 0; n < numSamples; ++n)
     {
-        float noise = (random.nextFloat() - 0.5f) * curGain;
-        buffer[n] += noise;
+        buffer[n] = (SampleType)(random.nextFloat() - 0.5f);
     }
 }
 
-void HissProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+template <typename SampleType>
+template <int NumChannels>
+void HissProcessor<SampleType>::process (const juce::dsp::ProcessContextReplacing<SampleType>& context)
 {
     auto& outBlock = context.getOutputBlock();
-    auto numChannels = outBlock.getNumChannels();
-    auto numSamples = outBlock.getNumSamples();
+    auto numChannels = getKernelChannelCount<NumChannels>(outBlock.getNumChannels());
+    auto numSamples = static_cast<int>(outBlock.getNumSamples());
+    jassert(numChannels <= noiseBuffer.getNumChannels() && numSamples <= noiseBuffer.getNumSamples());
+    
+    gain.setTargetValue((SampleType)targetGain.load());
+    auto isRamping = fillParameterRamp(gain, gainRamp.get(), numSamples);
+    
+    // while switching quality, both EQs run and the noise crossfades from one to the other
+    cheapBlend.setTargetValue(cheapHiss.load() ? 1 : 0);
+    auto isFading = fillParameterRamp(cheapBlend, cheapBlendRamp.get(), numSamples);
+    auto runFull = isFading || cheapBlend.getTargetValue() == 0;
+    auto runCheap = isFading || cheapBlend.getTargetValue() != 0;
+    
+    // a path that sat idle starts again from silence rather than from stale filter state
+    if (runFull && !fullPathActive)
+        for (int ch = 0; ch < numChannels; ++ch)
+            preProcessEQ[(size_t)ch].reset();
+    if (runCheap && !cheapPathActive)
+        for (int ch = 0; ch < numChannels; ++ch)
+            cheapEQ[(size_t)ch].reset();
+    fullPathActive = runFull;
+    cheapPathActive = runCheap;
 
     // Iterate over channels and process noise per channel
-    for (size_t ch = 0; ch < numChannels; ++ch)
+    for (int ch = 0; ch < numChannels; ++ch)
     {
-        float* channelData = outBlock.getChannelPointer(ch);
+        SampleType* noise = noiseBuffer.getWritePointer(ch);
+        SampleType* cheapNoise = cheapNoiseBuffer.getWritePointer(ch);
+        
+        processBlock(noise, numSamples);
         
-        processBlock(channelData, static_cast<int>(numSamples));
+        if (isFading)
+            juce::FloatVectorOperations::copy(cheapNoise, noise, numSamples);
+        else if (runCheap)
+            cheapNoise = noise;
         
-        // Wrap the raw buffer into a JUCE AudioBlock for DSP processing
-        juce::dsp::AudioBlock<float> channelBlock(&channelData, 1, numSamples);
-        juce::dsp::ProcessContextReplacing<float> eqContext(channelBlock);
+        // Only the noise goes through the EQ, the signal it is added to is left alone
+        if (runFull)
+        {
+            juce::dsp::AudioBlock<SampleType> noiseBlock(&noise, 1, (size_t)numSamples);
+            juce::dsp::ProcessContextReplacing<SampleType> eqContext(noiseBlock);
+            preProcessEQ[(size_t)ch].process(eqContext);
+        }
         
-        preProcessEQ.process(eqContext);
+        if (runCheap)
+        {
+            juce::dsp::AudioBlock<SampleType> cheapBlock(&cheapNoise, 1, (size_t)numSamples);
+            juce::dsp::ProcessContextReplacing<SampleType> cheapContext(cheapBlock);
+            cheapEQ[(size_t)ch].process(cheapContext);
+        }
+        
+        if (isFading)
+            crossfadeInto(cheapNoise, noise, cheapBlendRamp.get(), numSamples);
+        
+        auto* hiss = runCheap ? cheapNoise : noise;
+        
+        if (isRamping)
+            juce::FloatVectorOperations::addWithMultiply(outBlock.getChannelPointer((size_t)ch), hiss, gainRamp.get(), numSamples);
+        else
+            juce::FloatVectorOperations::addWithMultiply(outBlock.getChannelPointer((size_t)ch), hiss, gain.getTargetValue(), numSamples);
     }
 }
 
-void HissProcessor::reset ()
+template <typename SampleType>
+void HissProcessor<SampleType>::reset ()
 {
-    prevGain = curGain;
-    preProcessEQ.reset();
+    gain.setCurrentAndTargetValue((SampleType)targetGain.load());
+    for (auto& eq : preProcessEQ)
+        eq.reset();
+    for (auto& eq : cheapEQ)
+        eq.reset();
+    cheapBlend.setCurrentAndTargetValue(cheapHiss.load() ? 1 : 0);
 }
 
-void HissProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+template <typename SampleType>
+void HissProcessor<SampleType>::parameterChanged (const juce::String& parameterID, float newValue)
 {
     if (parameterID == Params::HISS)
     {
-        prevGain = curGain;
         hissPercentage = newValue;
         setGain(hissPercentage);
     }
 }
+
+template class HissProcessor<float>;
+template class HissProcessor<double>;
+
+#define TSATURATOR_INSTANTIATE_HISS(n) \
+    template void HissProcessor<float>::process<n> (const juce::dsp::ProcessContextReplacing<float>&); \
+    template void HissProcessor<double>::process<n> (const juce::dsp::ProcessContextReplacing<double>&);
+TSATURATOR_FOR_EACH_CHANNEL_COUNT(TSATURATOR_INSTANTIATE_HISS)
+#undef TSATURATOR_INSTANTIATE_HISS
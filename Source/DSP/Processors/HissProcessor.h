@@ -12,6 +12,9 @@
 
 #include <JuceHeader.h>
 #include "Params.h"
+#include "ChannelDispatch.h"
+#include "Smoothing.h"
+#include "SharedResources.h"
 
 /*
  Enum for the response curves in the EQ used to treat the hiss noise.
@@ -42,31 +45,57 @@ struct HissResponseCurveSettings
     float highCutFreq { 0 }, highCutSlope { 6.f };
 };
 
-using FilterPtr = juce::dsp::IIR::Coefficients<float>::Ptr;
-using Filter = juce::dsp::IIR::Filter<float>;
-using EQChain = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter, Filter, Filter, Filter, Filter>;
+template <typename SampleType>
+using FilterPtr = typename juce::dsp::IIR::Coefficients<SampleType>::Ptr;
+template <typename SampleType>
+using Filter = juce::dsp::IIR::Filter<SampleType>;
+template <typename SampleType>
+using EQChain = juce::dsp::ProcessorChain<Filter<SampleType>, Filter<SampleType>, Filter<SampleType>, Filter<SampleType>,
+                                          Filter<SampleType>, Filter<SampleType>, Filter<SampleType>, Filter<SampleType>>;
 
-FilterPtr peakFilter(float freq, float q, float gain, double sampleRate);
-FilterPtr lowCutFilter(const HissResponseCurveSettings& settings, double sampleRate);
-FilterPtr highCutFilter(const HissResponseCurveSettings& settings, double sampleRate);
-FilterPtr lowShelfFilter(const HissResponseCurveSettings& settings, double sampleRate);
-FilterPtr highShelfFilter(const HissResponseCurveSettings& settings, double sampleRate);
+/*
+ One set of EQ coefficients for a given sample rate and curve, shared by every instance and channel that uses it.
+ Only the filter state is per channel, the coefficients are never written after they are made.
+ */
+template <typename SampleType>
+struct HissEQCoefficients
+{
+    std::array<FilterPtr<SampleType>, HIGH_CUT + 1> bands;
+};
+
+template <typename SampleType>
+std::shared_ptr<const HissEQCoefficients<SampleType>> makeHissEQCoefficients(const HissResponseCurveSettings& settings, double sampleRate, const juce::String& key);
+
+template <typename SampleType>
+FilterPtr<SampleType> peakFilter(float freq, float q, float gain, double sampleRate);
+template <typename SampleType>
+FilterPtr<SampleType> lowCutFilter(const HissResponseCurveSettings& settings, double sampleRate);
+template <typename SampleType>
+FilterPtr<SampleType> highCutFilter(const HissResponseCurveSettings& settings, double sampleRate);
+template <typename SampleType>
+FilterPtr<SampleType> lowShelfFilter(const HissResponseCurveSettings& settings, double sampleRate);
+template <typename SampleType>
+FilterPtr<SampleType> highShelfFilter(const HissResponseCurveSettings& settings, double sampleRate);
 
 /*
  Handles how much hiss (filtered white noise) is outputted
  */
-class HissProcessor : public juce::dsp::ProcessorBase, public juce::AudioProcessorValueTreeState::Listener
+template <typename SampleType>
+class HissProcessor final : public juce::AudioProcessorValueTreeState::Listener
 {
 public:
     HissProcessor(juce::AudioProcessorValueTreeState& apvts);
     void setGain (float hissPercentage);
-    void initializeFilters(HissResponseCurveSettings& settings);
-    void prepare (const juce::dsp::ProcessSpec& _spec) override;
-    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
-    void reset () override;
+    void initializeFilters(const HissResponseCurveSettings& settings);
+    void prepare (const juce::dsp::ProcessSpec& _spec);
+    template <int NumChannels = dynamicChannelCount>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context);
+    void reset ();
     void parameterChanged (const juce::String& parameterID, float newValue) override;
-    void processBlock(float* buffer, int numSamples);
-    inline void updateCoefficients(Filter& filter, FilterPtr newCoefficients)
+    void processBlock(SampleType* buffer, int numSamples);
+    // the cheap hiss only keeps the low cut of the EQ, switching crossfades over qualityFadeSeconds
+    void setCheapHiss(bool shouldBeCheap) { cheapHiss.store(shouldBeCheap); }
+    inline void updateCoefficients(Filter<SampleType>& filter, FilterPtr<SampleType> newCoefficients)
     {
         filter.coefficients = newCoefficients;
     }
@@ -74,13 +103,24 @@ private:
     juce::AudioProcessorValueTreeState* apvts;
     juce::dsp::ProcessSpec spec;
     
-    EQChain preProcessEQ;
+    // IIR filters are single channel, so every channel gets its own chain to keep its filter state
+    std::array<EQChain<SampleType>, maxSupportedChannels> preProcessEQ;
+    SharedResources::Ptr<HissEQCoefficients<SampleType>> eqCoefficients;
+    
+    // quality governor fallback
+    std::atomic<bool> cheapHiss {false};
+    std::array<Filter<SampleType>, maxSupportedChannels> cheapEQ;
+    juce::AudioBuffer<SampleType> cheapNoiseBuffer;
+    juce::SmoothedValue<SampleType> cheapBlend;
+    ParameterRampBuffer<SampleType> cheapBlendRamp;
+    bool fullPathActive {false}, cheapPathActive {false};
+    juce::AudioBuffer<SampleType> noiseBuffer;
     HissResponseCurveSettings settings;
-    Filter LP, LS, B1, B2, B3, B4, B5, HS, HP;
     
-    // for white noise generation
-    float curGain = -60.0f;
-    float prevGain = curGain;
+    // for white noise generation, the gain is applied after the EQ so one ramp serves every channel
+    std::atomic<float> targetGain { juce::Decibels::decibelsToGain(-60.0f) };
+    juce::SmoothedValue<SampleType> gain;
+    ParameterRampBuffer<SampleType> gainRamp;
     
     juce::Random random;
     
@@ -12,51 +12,147 @@
 #include "MixProcessor.h"
 #include "Params.h"
 
-MixProcessor::MixProcessor (juce::AudioProcessorValueTreeState& apvts)
+template <typename SampleType>
+MixProcessor<SampleType>::MixProcessor (juce::AudioProcessorValueTreeState& apvts)
 {
     apvts.addParameterListener(Params::MIX, this);
+    parameterChanged(Params::MIX, apvts.getRawParameterValue(Params::MIX)->load());
 }
 
-void MixProcessor::prepare (const juce::dsp::ProcessSpec &_spec)
+/*
+ Sets how far (in samples) the wet signal lags the input, must be called before prepare() so the ring is sized for it
+ */
+template <typename SampleType>
+void MixProcessor<SampleType>::setWetLatency (int latencyInSamples)
+{
+    wetLatency = juce::jmax(0, latencyInSamples);
+}
+
+template <typename SampleType>
+void MixProcessor<SampleType>::prepare (const juce::dsp::ProcessSpec &_spec)
 {
     spec = _spec;
-    mixer.prepare(spec);
-    mixer.setMixingRule(juce::dsp::DryWetMixingRule::balanced);
+    // room for a full tile on top of the latency, so the read never overtakes the write
+    ringSize = wetLatency + (int)spec.maximumBlockSize;
+    dryRing.setSize((int)spec.numChannels, ringSize, false, false, true);
+    dryRing.clear();
+    writePos = 0;
+    
+    mix.reset(spec.sampleRate, parameterRampSeconds);
+    mix.setCurrentAndTargetValue(dryWetMix.load());
+    dryGainRamp.ensureSize(spec.maximumBlockSize);
+    wetGainRamp.ensureSize(spec.maximumBlockSize);
 }
 
-void MixProcessor::setDryBlock(juce::dsp::AudioBlock<const float> db)
+/*
+ Writes the incoming dry block into the delay ring. This is the only copy of the dry signal made per block.
+ */
+template <typename SampleType>
+template <int NumChannels>
+void MixProcessor<SampleType>::pushDryBlock (const juce::dsp::AudioBlock<const SampleType>& db)
 {
-    // Resize the storage buffer to match the input
-    dryBuffer.setSize((int)db.getNumChannels(), (int)db.getNumSamples(), false, false, true);
+    auto numSamples = (int)db.getNumSamples();
+    auto numChannels = getKernelChannelCount<NumChannels>(db.getNumChannels());
+    jassert(numChannels <= dryRing.getNumChannels());
+    jassert(numSamples <= (int)spec.maximumBlockSize);
+    
+    auto firstPart = juce::jmin(numSamples, ringSize - writePos);
+    auto secondPart = numSamples - firstPart;
     
-    // Copy dry samples into the storage buffer
-    for (size_t ch = 0; ch < db.getNumChannels(); ++ch)
+    for (int ch = 0; ch < numChannels; ++ch)
     {
-        dryBuffer.copyFrom((int)ch, 0, db.getChannelPointer(ch), (int)db.getNumSamples());
+        auto* src = db.getChannelPointer((size_t)ch);
+        dryRing.copyFrom(ch, writePos, src, firstPart);
+        if (secondPart > 0)
+            dryRing.copyFrom(ch, 0, src + firstPart, secondPart);
     }
+}
 
-    // Point originalDryBlock to the persistent buffer
-    originalDryBlock = juce::dsp::AudioBlock<float>(dryBuffer);
+/*
+ Applies the wet/dry gains to one contiguous run of samples, following the gain ramps when the mix knob has moved
+ */
+template <typename SampleType>
+void MixProcessor<SampleType>::mixChannel (SampleType* wet, const SampleType* dry, int numSamples, int rampOffset, bool isRamping)
+{
+    if (isRamping)
+    {
+        juce::FloatVectorOperations::multiply(wet, wetGainRamp.get() + rampOffset, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(wet, dry, dryGainRamp.get() + rampOffset, numSamples);
+    }
+    else
+    {
+        juce::FloatVectorOperations::multiply(wet, wetGain, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(wet, dry, dryGain, numSamples);
+    }
 }
 
-void MixProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+template <typename SampleType>
+template <int NumChannels>
+void MixProcessor<SampleType>::process (const juce::dsp::ProcessContextReplacing<SampleType>& context)
 {
-    auto wetBlock = context.getOutputBlock();
-    mixer.pushDrySamples(originalDryBlock);
-    mixer.setWetMixProportion(dryWetMix);
-    mixer.mixWetSamples(wetBlock);
+    auto& wetBlock = context.getOutputBlock();
+    auto numSamples = (int)wetBlock.getNumSamples();
+    auto numChannels = getKernelChannelCount<NumChannels>(wetBlock.getNumChannels());
+    jassert(numChannels <= dryRing.getNumChannels());
+    
+    mix.setTargetValue(dryWetMix.load());
+    auto isRamping = mix.isSmoothing();
+    
+    if (isRamping)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            getBalancedGains(mix.getNextValue(), dryGainRamp[i], wetGainRamp[i]);
+    }
+    else
+    {
+        getBalancedGains(mix.getTargetValue(), dryGain, wetGain);
+    }
+    
+    // the dry samples for this block were written at writePos, read them back delayed by the wet latency
+    auto readPos = writePos - wetLatency;
+    if (readPos < 0)
+        readPos += ringSize;
+    
+    auto firstPart = juce::jmin(numSamples, ringSize - readPos);
+    auto secondPart = numSamples - firstPart;
+    
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* wet = wetBlock.getChannelPointer((size_t)ch);
+        auto* dry = dryRing.getReadPointer(ch);
+        
+        mixChannel(wet, dry + readPos, firstPart, 0, isRamping);
+        if (secondPart > 0)
+            mixChannel(wet + firstPart, dry, secondPart, firstPart, isRamping);
+    }
+    
+    writePos = (writePos + numSamples) % ringSize;
 }
 
-void MixProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+template <typename SampleType>
+void MixProcessor<SampleType>::parameterChanged(const juce::String& parameterID, float newValue)
 {
     if (parameterID == Params::MIX)
     {
-        dryWetMix = newValue;
-        percentageToNumber();
+        dryWetMix.store(percentageToNumber(newValue));
     }
 }
 
-void MixProcessor::reset()
+template <typename SampleType>
+void MixProcessor<SampleType>::reset()
 {
-    mixer.reset();
+    dryRing.clear();
+    writePos = 0;
+    mix.setCurrentAndTargetValue(dryWetMix.load());
 }
+
+template class MixProcessor<float>;
+template class MixProcessor<double>;
+
+#define TSATURATOR_INSTANTIATE_MIX(n) \
+    template void MixProcessor<float>::pushDryBlock<n> (const juce::dsp::AudioBlock<const float>&); \
+    template void MixProcessor<float>::process<n> (const juce::dsp::ProcessContextReplacing<float>&); \
+    template void MixProcessor<double>::pushDryBlock<n> (const juce::dsp::AudioBlock<const double>&); \
+    template void MixProcessor<double>::process<n> (const juce::dsp::ProcessContextReplacing<double>&);
+TSATURATOR_FOR_EACH_CHANNEL_COUNT(TSATURATOR_INSTANTIATE_MIX)
+#undef TSATURATOR_INSTANTIATE_MIX
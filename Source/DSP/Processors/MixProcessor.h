@@ -13,29 +13,50 @@
 #include <JuceHeader.h>
 #include "Params.h"
 #include "SaturationProcessor.hpp"
+#include "ChannelDispatch.h"
+#include "Smoothing.h"
 
 /*
  Handles the balance of the wet and dry signal outputted by the application.
+ The dry signal is written once into a preallocated delay ring which is delayed by the latency of the wet path,
+ and then mixed straight into the output block so the two signals stay phase aligned.
  */
-class MixProcessor : public juce::dsp::ProcessorBase, public juce::AudioProcessorValueTreeState::Listener
+template <typename SampleType>
+class MixProcessor final : public juce::AudioProcessorValueTreeState::Listener
 {
 public:
     MixProcessor(juce::AudioProcessorValueTreeState& apvts);
-    void prepare (const juce::dsp::ProcessSpec& _spec) override;
-    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
-    void reset () override;
+    void prepare (const juce::dsp::ProcessSpec& _spec);
+    template <int NumChannels = dynamicChannelCount>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context);
+    void reset ();
     void parameterChanged (const juce::String& parameterID, float newValue) override;
-    inline void percentageToNumber() { dryWetMix /= 100.f; };
-    void setDryBlock(juce::dsp::AudioBlock<const float> db);
+    inline static float percentageToNumber(float percentage) { return percentage / 100.f; };
+    void setWetLatency (int latencyInSamples);
+    template <int NumChannels = dynamicChannelCount>
+    void pushDryBlock (const juce::dsp::AudioBlock<const SampleType>& db);
 private:
+    // balanced mixing rule, both signals at unity gain at 50%
+    inline static void getBalancedGains (float mix, SampleType& dryGain, SampleType& wetGain)
+    {
+        dryGain = (SampleType)juce::jmin(1.f, 2.f * (1.f - mix));
+        wetGain = (SampleType)juce::jmin(1.f, 2.f * mix);
+    }
+    void mixChannel (SampleType* wet, const SampleType* dry, int numSamples, int rampOffset, bool isRamping);
+    
     juce::AudioProcessorValueTreeState* apvts;
     juce::dsp::ProcessSpec spec;
     
-    juce::dsp::DryWetMixer<float> mixer;
-    juce::AudioBuffer<float> dryBuffer;
-    juce::dsp::AudioBlock<const float> originalDryBlock;
-    float dryWetMix {0.f};
-    float prevDryWet {0.f};
+    juce::AudioBuffer<SampleType> dryRing;
+    int ringSize {0};
+    int writePos {0};
+    int wetLatency {0};
+    
+    // the mix position is smoothed, the balanced law is then applied per sample while it moves
+    std::atomic<float> dryWetMix {0.f};
+    juce::SmoothedValue<float> mix;
+    SampleType dryGain {1}, wetGain {0};
+    ParameterRampBuffer<SampleType> dryGainRamp, wetGainRamp;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MixProcessor)
 };
@@ -8,72 +8,264 @@
 #include "SaturationProcessor.hpp"
 #include "Params.h"
 
-SaturationProcessor::SaturationProcessor(juce::AudioProcessorValueTreeState& apvts)
+template <typename SampleType>
+SaturationProcessor<SampleType>::SaturationProcessor(juce::AudioProcessorValueTreeState& apvts)
 {
     apvts.addParameterListener(Params::SATURATION, this);
+    parameterChanged(Params::SATURATION, apvts.getRawParameterValue(Params::SATURATION)->load());
 }
 
-void SaturationProcessor::setCompressorSettings()
+/*
+ The gain the upsampled signal is pushed into the curve with
+ */
+template <typename SampleType>
+SampleType SaturationProcessor<SampleType>::getTargetSaturationLevel()
 {
-    processorChain.get<SaturationChainPositions::COMPRESSION>().setRatio(1.f);
-    processorChain.get<SaturationChainPositions::COMPRESSION>().setAttack(30.f);
-    processorChain.get<SaturationChainPositions::COMPRESSION>().setRelease(50.f);
-    processorChain.get<SaturationChainPositions::COMPRESSION>().setThreshold(-30.f);
+    if (saturation.load() == 0.01f)
+        return (SampleType)1;
+    
+    return (SampleType)(1.0f + getSaturationMultiplier());
 }
 
-void SaturationProcessor::prepare(const juce::dsp::ProcessSpec &_spec)
+template <typename SampleType>
+void SaturationProcessor<SampleType>::setCompressorSettings()
 {
+    processorChain.template get<SaturationChainPositions::COMPRESSION>().setRatio(1.f);
+    processorChain.template get<SaturationChainPositions::COMPRESSION>().setAttack(30.f);
+    processorChain.template get<SaturationChainPositions::COMPRESSION>().setRelease(50.f);
+    processorChain.template get<SaturationChainPositions::COMPRESSION>().setThreshold(-30.f);
+}
+
+template <typename SampleType>
+void SaturationProcessor<SampleType>::prepare(const juce::dsp::ProcessSpec &_spec)
+{
+    // the half-band designs don't depend on the sample rate, so the oversamplers only have to be
+    // rebuilt when the channel count changes, and only re-sized when the block size does
+    auto needsNewOversampler = oversampler == nullptr || _spec.numChannels != spec.numChannels;
+    auto needsNewBuffers = needsNewOversampler || _spec.maximumBlockSize != spec.maximumBlockSize;
+    
     spec = _spec;
-    processorChain.get<SaturationChainPositions::COMPRESSION>().prepare(spec);
+    processorChain.template get<SaturationChainPositions::COMPRESSION>().prepare(spec);
     setCompressorSettings();
-    oversampler.reset();
-    constexpr size_t oversampleFactor = 2;
-    constexpr auto filterType = juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
-    oversampler = std::make_unique<juce::dsp::Oversampling<float>>(spec.numChannels, oversampleFactor, filterType);
-    oversampler->initProcessing(spec.maximumBlockSize);
+    
+    if (needsNewOversampler)
+    {
+        oversampler.reset();
+        reducedOversampler.reset();
+        constexpr auto filterType = juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR;
+        // the factor is a number of 2x stages, so 4x and the 2x fallback
+        oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(spec.numChannels, 2, filterType);
+        reducedOversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(spec.numChannels, 1, filterType);
+    }
+    
+    if (needsNewBuffers)
+    {
+        oversampler->initProcessing(spec.maximumBlockSize);
+        reducedOversampler->initProcessing(spec.maximumBlockSize);
+    }
+    
+    auto oversampledSamples = spec.maximumBlockSize * oversampler->getOversamplingFactor();
+    satLevel.reset(spec.sampleRate * (double)oversampler->getOversamplingFactor(), parameterRampSeconds);
+    reducedSatLevel.reset(spec.sampleRate * (double)reducedOversampler->getOversamplingFactor(), parameterRampSeconds);
+    satLevelRamp.ensureSize(oversampledSamples);
+    
+    reducedDelay = juce::jmax(0, juce::roundToInt(oversampler->getLatencyInSamples() - reducedOversampler->getLatencyInSamples()));
+    reducedDelayLine.setSize((int)spec.numChannels, juce::jmax(1, reducedDelay), false, false, true);
+    reducedPathBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize, false, false, true);
+    
+    oversamplingBlend.reset(spec.sampleRate, qualityFadeSeconds);
+    curveBlend.reset(spec.sampleRate, qualityFadeSeconds);
+    oversamplingBlendRamp.ensureSize(spec.maximumBlockSize);
+    
+    // clears the oversamplers and delay line, and snaps every smoother to where it should be
+    reset();
 }
 
-
-void SaturationProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+/*
+ Runs one oversampler's worth of the saturation over block in place
+ */
+template <typename SampleType>
+template <int NumChannels>
+void SaturationProcessor<SampleType>::saturate (juce::dsp::Oversampling<SampleType>& os, juce::SmoothedValue<SampleType>& level, juce::dsp::AudioBlock<SampleType> block)
 {
     // upsample
-    auto upsampledBlock = oversampler->processSamplesUp(context.getInputBlock());
+    auto upsampledBlock = os.processSamplesUp(block);
     // Scale input before passing through waveshaper
-    float satLevel = 1.0f + getSaturationMultiplier();
-
-    if (saturation == 0.01f)
-        satLevel = 1.0f;
+    level.setTargetValue(getTargetSaturationLevel());
+    
     // apply saturation level from knob
-    for (size_t channel = 0; channel < upsampledBlock.getNumChannels(); ++channel)
+    auto numChannels = getKernelChannelCount<NumChannels>(upsampledBlock.getNumChannels());
+    auto numUpsampled = (int)upsampledBlock.getNumSamples();
+    
+    if (fillParameterRamp(level, satLevelRamp.get(), numUpsampled))
     {
-        auto* channelData = upsampledBlock.getChannelPointer(channel);
-        for (size_t sample = 0; sample < upsampledBlock.getNumSamples(); ++sample)
-            channelData[sample] *= satLevel;
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(upsampledBlock.getChannelPointer((size_t)channel), satLevelRamp.get(), numUpsampled);
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(upsampledBlock.getChannelPointer((size_t)channel), level.getTargetValue(), numUpsampled);
+    }
+    juce::dsp::ProcessContextReplacing<SampleType> upsampledContext(upsampledBlock);
+    
+    if (curveMix == 0 || curveMix == 1)
+    {
+        setDistortionTransferFunction(curveMix == 1);
+        processorChain.process(upsampledContext);
+    }
+    else
+    {
+        // part way between the two curves, so shape by hand and only let the chain compress
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = upsampledBlock.getChannelPointer((size_t)channel);
+            for (int i = 0; i < numUpsampled; ++i)
+            {
+                auto exact = tapeCurve(data[i]);
+                data[i] = exact + (approximateTapeCurve(data[i]) - exact) * curveMix;
+            }
+        }
+        processorChain.template setBypassed<SaturationChainPositions::DISTORTION>(true);
+        processorChain.process(upsampledContext);
+        processorChain.template setBypassed<SaturationChainPositions::DISTORTION>(false);
     }
-    juce::dsp::ProcessContextReplacing<float> upsampledContext(upsampledBlock);
-    setDistortionTransferFunction(upsampledContext);
-    processorChain.process(upsampledContext);
 
     // downsample
-    oversampler->processSamplesDown(context.getOutputBlock());
+    os.processSamplesDown(block);
 }
 
-void SaturationProcessor::reset ()
+/*
+ Delays the 2x path by the difference between the two oversamplers' latencies
+ */
+template <typename SampleType>
+void SaturationProcessor<SampleType>::delayReducedPath (const juce::dsp::AudioBlock<SampleType>& block)
+{
+    if (reducedDelay == 0)
+        return;
+    
+    auto numSamples = (int)block.getNumSamples();
+    
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        auto* data = block.getChannelPointer(ch);
+        auto* line = reducedDelayLine.getWritePointer((int)ch);
+        auto pos = reducedDelayPos;
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            std::swap(data[i], line[pos]);
+            if (++pos == reducedDelay)
+                pos = 0;
+        }
+    }
+    
+    reducedDelayPos = (reducedDelayPos + numSamples) % reducedDelay;
+}
+
+template <typename SampleType>
+template <int NumChannels>
+void SaturationProcessor<SampleType>::process (const juce::dsp::ProcessContextReplacing<SampleType>& context)
+{
+    auto& block = context.getOutputBlock();
+    auto numSamples = (int)block.getNumSamples();
+    
+    // the curve only moves once per tile, the two curves are close enough that the steps can't be heard
+    curveBlend.setTargetValue(approximateCurve.load() ? 1 : 0);
+    curveMix = curveBlend.skip(numSamples);
+    
+    // while switching oversampling, both paths run and the output crossfades from one to the other
+    oversamplingBlend.setTargetValue(reducedOversampling.load() ? 1 : 0);
+    auto isFading = fillParameterRamp(oversamplingBlend, oversamplingBlendRamp.get(), numSamples);
+    auto runFull = isFading || oversamplingBlend.getTargetValue() == 0;
+    auto runReduced = isFading || oversamplingBlend.getTargetValue() != 0;
+    
+    // a path that sat idle starts again from silence, picking up the other path's saturation level
+    if (runFull && !fullPathActive)
+    {
+        oversampler->reset();
+        satLevel.setCurrentAndTargetValue(reducedSatLevel.getCurrentValue());
+    }
+    if (runReduced && !reducedPathActive)
+    {
+        reducedOversampler->reset();
+        reducedDelayLine.clear();
+        reducedSatLevel.setCurrentAndTargetValue(satLevel.getCurrentValue());
+    }
+    fullPathActive = runFull;
+    reducedPathActive = runReduced;
+    
+    if (!isFading)
+    {
+        if (runFull)
+        {
+            saturate<NumChannels>(*oversampler, satLevel, block);
+        }
+        else
+        {
+            saturate<NumChannels>(*reducedOversampler, reducedSatLevel, block);
+            delayReducedPath(block);
+        }
+        return;
+    }
+    
+    auto reducedBlock = juce::dsp::AudioBlock<SampleType>(reducedPathBuffer)
+                            .getSubsetChannelBlock(0, block.getNumChannels())
+                            .getSubBlock(0, (size_t)numSamples);
+    reducedBlock.copyFrom(block);
+    
+    saturate<NumChannels>(*reducedOversampler, reducedSatLevel, reducedBlock);
+    delayReducedPath(reducedBlock);
+    saturate<NumChannels>(*oversampler, satLevel, block);
+    
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        crossfadeInto(reducedBlock.getChannelPointer(ch), block.getChannelPointer(ch), oversamplingBlendRamp.get(), numSamples);
+        juce::FloatVectorOperations::copy(block.getChannelPointer(ch), reducedBlock.getChannelPointer(ch), numSamples);
+    }
+}
+
+template <typename SampleType>
+void SaturationProcessor<SampleType>::reset ()
 {
     oversampler->reset();
+    reducedOversampler->reset();
     processorChain.reset();
+    reducedDelayLine.clear();
+    reducedDelayPos = 0;
+    
+    satLevel.setCurrentAndTargetValue(getTargetSaturationLevel());
+    reducedSatLevel.setCurrentAndTargetValue(getTargetSaturationLevel());
+    
+    auto reduced = reducedOversampling.load();
+    oversamplingBlend.setCurrentAndTargetValue(reduced ? 1 : 0);
+    curveBlend.setCurrentAndTargetValue(approximateCurve.load() ? 1 : 0);
+    curveMix = curveBlend.getCurrentValue();
+    fullPathActive = !reduced;
+    reducedPathActive = reduced;
 }
 
-void SaturationProcessor::parameterChanged (const juce::String& parameterID, float newValue)
+template <typename SampleType>
+void SaturationProcessor<SampleType>::parameterChanged (const juce::String& parameterID, float newValue)
 {
     if (parameterID == Params::SATURATION)
     {
-        prevSaturation = saturation;
-        saturation = newValue;
+        prevSaturation = saturation.load();
+        saturation.store(newValue);
     }
 }
 
-float SaturationProcessor::getLatencyInSamples()
+template <typename SampleType>
+float SaturationProcessor<SampleType>::getLatencyInSamples()
 {
     return oversampler == nullptr ? 0.0f : oversampler->getLatencyInSamples();
 }
+
+template class SaturationProcessor<float>;
+template class SaturationProcessor<double>;
+
+#define TSATURATOR_INSTANTIATE_SATURATION(n) \
+    template void SaturationProcessor<float>::process<n> (const juce::dsp::ProcessContextReplacing<float>&); \
+    template void SaturationProcessor<double>::process<n> (const juce::dsp::ProcessContextReplacing<double>&);
+TSATURATOR_FOR_EACH_CHANNEL_COUNT(TSATURATOR_INSTANTIATE_SATURATION)
+#undef TSATURATOR_INSTANTIATE_SATURATION
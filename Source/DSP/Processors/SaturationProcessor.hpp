@@ -9,6 +9,8 @@
 
 #include <JuceHeader.h>
 #include "Params.h"
+#include "ChannelDispatch.h"
+#include "Smoothing.h"
 
 /*
  Enum for the processor chain that the saturation processor goes through.
@@ -22,40 +24,79 @@ enum SaturationChainPositions
 /*
  Handles applying saturation to the input signal based on the value of the knob
  */
-class SaturationProcessor : public juce::dsp::ProcessorBase, public juce::AudioProcessorValueTreeState::Listener
+template <typename SampleType>
+class SaturationProcessor final : public juce::AudioProcessorValueTreeState::Listener
 {
 public:
     SaturationProcessor(juce::AudioProcessorValueTreeState& apvts);
 
-    inline float getSaturationMultiplier() { return std::pow(saturation / 100.f, 2.0f); };
+    inline float getSaturationMultiplier() { return std::pow(saturation.load() / 100.f, 2.0f); };
     inline float getMaxBlockSize() const { return spec.maximumBlockSize; }
-    void prepare (const juce::dsp::ProcessSpec& _spec) override;
-    void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
-    void reset () override;
+    void prepare (const juce::dsp::ProcessSpec& _spec);
+    template <int NumChannels = dynamicChannelCount>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context);
+    void reset ();
     void parameterChanged (const juce::String& parameterID, float newValue) override;
     float getLatencyInSamples();
     void setCompressorSettings();
+    SampleType getTargetSaturationLevel();
+    
+    // quality governor fallbacks, both crossfade over qualityFadeSeconds
+    void setReducedOversampling (bool shouldReduce) { reducedOversampling.store(shouldReduce); }
+    void setApproximateCurve (bool shouldApproximate) { approximateCurve.store(shouldApproximate); }
     
 private:
     juce::AudioProcessorValueTreeState* apvts;
     
-    float saturation;
+    std::atomic<float> saturation {0.f};
     float prevSaturation;
 
     juce::dsp::ProcessSpec spec;
     
-    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    // runs at the oversampled rate, so the ramp holds a whole upsampled tile
+    juce::SmoothedValue<SampleType> satLevel;
+    ParameterRampBuffer<SampleType> satLevelRamp;
+    
+    std::unique_ptr<juce::dsp::Oversampling<SampleType>> oversampler;
     
-    using SaturationChain = juce::dsp::ProcessorChain<juce::dsp::WaveShaper<float>, juce::dsp::Compressor<float>>;
+    using SaturationChain = juce::dsp::ProcessorChain<juce::dsp::WaveShaper<SampleType>, juce::dsp::Compressor<SampleType>>;
     SaturationChain processorChain;
     
+    // the 2x fallback path, delayed to line up with the 4x path so the reported latency never changes
+    std::unique_ptr<juce::dsp::Oversampling<SampleType>> reducedOversampler;
+    juce::SmoothedValue<SampleType> reducedSatLevel;
+    juce::AudioBuffer<SampleType> reducedPathBuffer;
+    juce::AudioBuffer<SampleType> reducedDelayLine;
+    int reducedDelay {0}, reducedDelayPos {0};
+    
+    std::atomic<bool> reducedOversampling {false}, approximateCurve {false};
+    juce::SmoothedValue<SampleType> oversamplingBlend, curveBlend;
+    ParameterRampBuffer<SampleType> oversamplingBlendRamp;
+    SampleType curveMix {0};
+    bool fullPathActive {true}, reducedPathActive {false};
+    
+    template <int NumChannels>
+    void saturate (juce::dsp::Oversampling<SampleType>& os, juce::SmoothedValue<SampleType>& level, juce::dsp::AudioBlock<SampleType> block);
+    void delayReducedPath (const juce::dsp::AudioBlock<SampleType>& block);
+    
+    static SampleType tapeCurve (SampleType x)
+    {
+        return (std::tanh(x) * (SampleType)5) / (std::tanh((SampleType)5));
+    }
+    
+    // rational fit of tanh, clamped where it meets +-1 at |x| = 3
+    static SampleType approximateTapeCurve (SampleType x)
+    {
+        x = juce::jlimit((SampleType)-3, (SampleType)3, x);
+        auto x2 = x * x;
+        return x * ((SampleType)27 + x2) / ((SampleType)27 + (SampleType)9 * x2) * ((SampleType)5 / (SampleType)0.99990920);
+    }
+    
     // sets the transfer function
-    void setDistortionTransferFunction(const juce::dsp::ProcessContextReplacing<float> &context)
+    void setDistortionTransferFunction(bool useApproximation)
     {
-        auto& waveshaper = processorChain.get<SaturationChainPositions::DISTORTION>();
+        auto& waveshaper = processorChain.template get<SaturationChainPositions::DISTORTION>();
         
-        waveshaper.functionToUse = [] (float x) {
-            return (std::tanh(x) * 5.f) / (std::tanh(5.f));
-        };
+        waveshaper.functionToUse = useApproximation ? approximateTapeCurve : tapeCurve;
     }
 };
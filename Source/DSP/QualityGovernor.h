@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+    Created: 19 Oct 2026 4:52:30pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Quality tiers, from full quality down. Each tier keeps every saving of the tiers above it.
+ */
+enum class QualityTier
+{
+    Full,
+    DecimatedAnalyzer,      // the analyzer only takes every fourth FFT frame
+    CheapHiss,              // the hiss skips its EQ apart from the low cut
+    ReducedOversampling,    // the saturation runs at 2x instead of 4x
+    ApproximateCurve        // the tanh curve is swapped for a rational approximation
+};
+
+/*
+ Watches how much of each block's real-time deadline processBlock uses, and steps the quality down one tier at a time
+ when it gets too close. Recovery is slower than the step down, so the tier doesn't flap around a threshold.
+ Only update() is called from the audio thread, the current tier can be read from anywhere.
+ */
+class QualityGovernor
+{
+public:
+    static constexpr double stepDownLoad = 0.75;        // fraction of the deadline that counts as overloaded
+    static constexpr double recoverLoad = 0.4;          // and the fraction that has to hold before stepping back up
+    static constexpr double settleSeconds = 0.5;        // time a new tier gets before the load is judged again
+    static constexpr double recoverSeconds = 3.0;       // time the load has to stay low before stepping up
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        smoothedLoad = 0.0;
+        secondsSinceChange = 0.0;
+        secondsUnderRecoverLoad = 0.0;
+    }
+
+    // offline renders have no deadline, so the governor stays at full quality there
+    void setEnabled (bool shouldBeEnabled)
+    {
+        enabled = shouldBeEnabled;
+        if (!enabled)
+            tier.store((int)QualityTier::Full);
+    }
+
+    /*
+     Feeds in how long the last block took, returns the tier the next block should run at
+     */
+    QualityTier update (double elapsedSeconds, int numSamples)
+    {
+        if (!enabled || numSamples <= 0 || sampleRate <= 0.0)
+            return getCurrentTier();
+
+        auto blockSeconds = (double)numSamples / sampleRate;
+        auto load = elapsedSeconds / blockSeconds;
+
+        // rise quickly, fall slowly: one bad block matters, one good block doesn't
+        smoothedLoad = load > smoothedLoad ? 0.5 * (smoothedLoad + load) : 0.95 * smoothedLoad + 0.05 * load;
+        secondsSinceChange += blockSeconds;
+        secondsUnderRecoverLoad = smoothedLoad < recoverLoad ? secondsUnderRecoverLoad + blockSeconds : 0.0;
+
+        auto current = tier.load();
+
+        if (secondsSinceChange >= settleSeconds)
+        {
+            if (smoothedLoad > stepDownLoad && current < (int)QualityTier::ApproximateCurve)
+                changeTier(current + 1);
+            else if (secondsUnderRecoverLoad >= recoverSeconds && current > (int)QualityTier::Full)
+                changeTier(current - 1);
+        }
+
+        return getCurrentTier();
+    }
+
+    QualityTier getCurrentTier() const { return (QualityTier)tier.load(); }
+
+    static juce::String getTierName (QualityTier t)
+    {
+        switch (t)
+        {
+            case QualityTier::Full: return "Full Quality";
+            case QualityTier::DecimatedAnalyzer: return "Eco: Analyzer";
+            case QualityTier::CheapHiss: return "Eco: Hiss";
+            case QualityTier::ReducedOversampling: return "Eco: 2x OS";
+            case QualityTier::ApproximateCurve: return "Eco: Curve";
+        }
+        return {};
+    }
+
+private:
+    void changeTier (int newTier)
+    {
+        tier.store(newTier);
+        secondsSinceChange = 0.0;
+        secondsUnderRecoverLoad = 0.0;
+    }
+
+    std::atomic<int> tier {(int)QualityTier::Full};
+    double sampleRate {0.0};
+    double smoothedLoad {0.0};
+    double secondsSinceChange {0.0};
+    double secondsUnderRecoverLoad {0.0};
+    bool enabled {true};
+};
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    SharedResources.h
+    Created: 19 Oct 2026 3:12:44pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/*
+ A process-wide registry of immutable data that would otherwise be identical in every plugin instance
+ (FFT tables, analysis windows, filter coefficients, decoded images).
+ The registry only holds weak references, so a resource lives exactly as long as some instance is using it.
+ Keys have to describe everything the resource depends on (sample rate, sizes, sample type...).
+ */
+class SharedResources
+{
+public:
+    template <typename Resource>
+    using Ptr = std::shared_ptr<const Resource>;
+
+    /*
+     Returns the resource stored under key, building it with create() if no instance currently holds one.
+     Only call this from prepare()/constructors, never from the audio thread, since it locks and may allocate.
+     */
+    template <typename Resource, typename Factory>
+    static Ptr<Resource> get (const juce::String& key, Factory&& create)
+    {
+        auto& registry = getRegistry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+
+        if (auto existing = registry.resources[key].lock())
+            return std::static_pointer_cast<const Resource>(existing);
+
+        Ptr<Resource> created = create();
+        registry.resources[key] = created;
+        registry.removeExpired();
+        return created;
+    }
+
+    /*
+     Turns a plain settings struct into a key fragment, so resources built from it are shared only between
+     instances using exactly the same settings
+     */
+    template <typename Settings>
+    static juce::String describe (const Settings& settings)
+    {
+        static_assert(std::is_trivially_copyable<Settings>::value, "settings must be plain data");
+
+        // FNV-1a over the raw bytes
+        juce::uint64 hash = 14695981039346656037ull;
+        auto* bytes = reinterpret_cast<const juce::uint8*>(&settings);
+        for (size_t i = 0; i < sizeof(Settings); ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+        return juce::String::toHexString((juce::int64)hash);
+    }
+
+private:
+    struct Registry
+    {
+        void removeExpired()
+        {
+            for (auto it = resources.begin(); it != resources.end();)
+                it = it->second.expired() ? resources.erase(it) : std::next(it);
+        }
+
+        std::mutex mutex;
+        std::map<juce::String, std::weak_ptr<const void>> resources;
+    };
+
+    static Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    Smoothing.h
+    Created: 19 Oct 2026 1:48:12pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// how long a knob change takes to reach its new value. This is independent of the host and tile size,
+// so a ramp simply carries on into the next tile
+static constexpr double parameterRampSeconds = 0.02;
+
+/*
+ Scratch space for one tile of a parameter ramp. Only reallocates when a prepare() asks for more room than it already has.
+ */
+template <typename SampleType>
+struct ParameterRampBuffer
+{
+    void ensureSize (size_t numSamples)
+    {
+        if (numSamples > capacity)
+        {
+            data.allocate(numSamples, true);
+            capacity = numSamples;
+        }
+    }
+    
+    SampleType* get() const { return data.get(); }
+    SampleType& operator[] (int index) const { return data[index]; }
+    
+private:
+    juce::HeapBlock<SampleType> data;
+    size_t capacity {0};
+};
+
+/*
+ Writes the next numSamples values of a smoothed parameter into ramp. Returns false (and writes nothing) once the value has
+ settled, so the caller can take the cheaper constant gain path.
+ */
+template <typename SampleType>
+inline bool fillParameterRamp (juce::SmoothedValue<SampleType>& value, SampleType* ramp, int numSamples)
+{
+    if (!value.isSmoothing())
+        return false;
+    
+    for (int i = 0; i < numSamples; ++i)
+        ramp[i] = value.getNextValue();
+    
+    return true;
+}
+
+// how long a quality tier change takes to crossfade from the old path to the new one
+static constexpr double qualityFadeSeconds = 0.05;
+
+/*
+ Blends a into b in place, following ramp: 0 leaves only a, 1 leaves only b
+ */
+template <typename SampleType>
+inline void crossfadeInto (SampleType* b, const SampleType* a, const SampleType* ramp, int numSamples)
+{
+    juce::FloatVectorOperations::subtract(b, a, numSamples);
+    juce::FloatVectorOperations::multiply(b, ramp, numSamples);
+    juce::FloatVectorOperations::add(b, a, numSamples);
+}
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    StereoScope.h
+    Created: 19 Oct 2026 9:31:05pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Feeds the correlation meter and goniometer. The correlation is kept on the audio thread from running sums of
+ L*R, L*L and R*R, and only the resulting coefficient is published. The goniometer gets every n-th L/R pair through
+ a lock-free ring, and only while an editor is reading them, otherwise the audio thread just keeps the sums.
+ The ring's storage only exists while it's being fed, so a processor without an open editor doesn't carry it.
+ */
+class StereoScope
+{
+public:
+    static constexpr int ringSize = 4096;
+    static constexpr double pointsPerSecond = 12000.0;
+    static constexpr double correlationSeconds = 0.3;
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        decimation = juce::jmax(1, juce::roundToInt(sampleRate / pointsPerSecond));
+        samplesUntilPoint = 0;
+        sumLR = sumLL = sumRR = 0.0;
+        correlation.store(0.0f);
+    }
+
+    template <typename SampleType>
+    void process (const SampleType* left, const SampleType* right, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        accumulateCorrelation(left, right, numSamples);
+
+        // setFeeding(false) waits for this to leave before freeing the points
+        feedUsers.fetch_add(1);
+        if (feeding.load())
+            pushPoints(left, right, numSamples);
+        else
+            samplesUntilPoint = 0;
+        feedUsers.fetch_sub(1);
+    }
+
+    // +1 is mono, 0 unrelated, -1 out of phase. Silence reads as 0
+    float getCorrelation() const { return correlation.load(); }
+
+    // message thread: whether anyone is reading the points, allocates their storage or frees it
+    void setFeeding (bool shouldFeed)
+    {
+        if (shouldFeed == (points != nullptr))
+            return;
+
+        if (shouldFeed)
+        {
+            // the audio thread stays out of the ring until feeding is set, so it can start over empty
+            points = std::make_unique<Points>();
+            pointRing.reset();
+            feeding.store(true);
+            return;
+        }
+
+        feeding.store(false);
+        while (feedUsers.load() != 0)
+            juce::Thread::yield();
+
+        points.reset();
+    }
+
+    // message thread: hands back up to maxPoints of the oldest points not read yet
+    int readPoints (float* left, float* right, int maxPoints)
+    {
+        if (points == nullptr)
+            return 0;
+
+        const auto* pointLeft = points->left;
+        const auto* pointRight = points->right;
+        int start1, size1, start2, size2;
+        pointRing.prepareToRead(maxPoints, start1, size1, start2, size2);
+        std::copy(pointLeft + start1, pointLeft + start1 + size1, left);
+        std::copy(pointRight + start1, pointRight + start1 + size1, right);
+        std::copy(pointLeft + start2, pointLeft + start2 + size2, left + size1);
+        std::copy(pointRight + start2, pointRight + start2 + size2, right + size1);
+        pointRing.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    // the block's sums go into four lanes each so they vectorise, then into exponentially fading running totals
+    template <typename SampleType>
+    void accumulateCorrelation (const SampleType* left, const SampleType* right, int numSamples)
+    {
+        SampleType lr[4] = {}, ll[4] = {}, rr[4] = {};
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                auto l = left[i + lane];
+                auto r = right[i + lane];
+                lr[lane] += l * r;
+                ll[lane] += l * l;
+                rr[lane] += r * r;
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            lr[0] += left[i] * right[i];
+            ll[0] += left[i] * left[i];
+            rr[0] += right[i] * right[i];
+        }
+
+        auto fade = std::exp(-(double)numSamples / (sampleRate * correlationSeconds));
+        sumLR = fade * sumLR + (double)((lr[0] + lr[1]) + (lr[2] + lr[3]));
+        sumLL = fade * sumLL + (double)((ll[0] + ll[1]) + (ll[2] + ll[3]));
+        sumRR = fade * sumRR + (double)((rr[0] + rr[1]) + (rr[2] + rr[3]));
+
+        auto energy = std::sqrt(sumLL * sumRR);
+        correlation.store(energy > 1.0e-12 ? (float)juce::jlimit(-1.0, 1.0, sumLR / energy) : 0.0f);
+    }
+
+    // points that don't fit are dropped, the goniometer only ever needs the most recent ones anyway
+    template <typename SampleType>
+    void pushPoints (const SampleType* left, const SampleType* right, int numSamples)
+    {
+        auto numPoints = samplesUntilPoint < numSamples ? (numSamples - samplesUntilPoint - 1) / decimation + 1 : 0;
+
+        int start1, size1, start2, size2;
+        pointRing.prepareToWrite(numPoints, start1, size1, start2, size2);
+
+        auto index = samplesUntilPoint;
+        for (int p = 0; p < size1 + size2; ++p, index += decimation)
+        {
+            auto slot = p < size1 ? start1 + p : start2 + p - size1;
+            points->left[slot] = static_cast<float>(left[index]);
+            points->right[slot] = static_cast<float>(right[index]);
+        }
+
+        pointRing.finishedWrite(size1 + size2);
+        samplesUntilPoint = samplesUntilPoint + numPoints * decimation - numSamples;
+    }
+
+    double sampleRate = 44100.0;
+    double sumLR = 0.0, sumLL = 0.0, sumRR = 0.0;
+    std::atomic<float> correlation {0.0f};
+
+    struct Points
+    {
+        float left[ringSize] = {};
+        float right[ringSize] = {};
+    };
+
+    std::atomic<bool> feeding {false};
+    std::atomic<int> feedUsers {0};
+    int decimation = 4;
+    int samplesUntilPoint = 0;
+    juce::AbstractFifo pointRing {ringSize};
+    std::unique_ptr<Points> points;
+};
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    TableCache.cpp
+    Created: 19 Oct 2026 4:05:19pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#include "TableCache.h"
+
+static constexpr char cacheMagic[4] = { 't', 'S', 'T', 'C' };
+
+juce::File TableCache::getCacheDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("tSaturator")
+               .getChildFile("Cache");
+}
+
+/*
+ Identifies this build, so tables written by an older (or newer) version of the plugin are never trusted
+ */
+juce::uint64 TableCache::getBuildHash()
+{
+   #ifdef JucePlugin_VersionString
+    static const juce::String build = juce::String(JucePlugin_VersionString) + " " + __DATE__ + " " + __TIME__;
+   #else
+    static const juce::String build = juce::String(__DATE__) + " " + __TIME__;
+   #endif
+    return (juce::uint64)build.hashCode64();
+}
+
+/*
+ FNV-1a, used for the payload checksum
+ */
+juce::uint64 TableCache::hashBytes(const void* data, size_t numBytes)
+{
+    juce::uint64 hash = 14695981039346656037ull;
+    auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t i = 0; i < numBytes; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    return hash;
+}
+
+juce::File TableCache::getFileFor(const juce::String& key)
+{
+    auto name = juce::String::toHexString((juce::int64)getBuildHash()) + "-" + juce::String::toHexString(key.hashCode64());
+    return getCacheDirectory().getChildFile(name + ".table");
+}
+
+std::unique_ptr<juce::MemoryMappedFile> TableCache::mapIfValid(const juce::File& file, const juce::String& key,
+                                                               size_t valueSize, size_t& payloadOffset)
+{
+    if (! file.existsAsFile())
+        return nullptr;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* data = static_cast<const char*>(mapped->getData());
+    auto size = mapped->getSize();
+
+    if (data == nullptr || size < sizeof(Header))
+        return nullptr;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    auto keySize = key.getNumBytesAsUTF8();
+    payloadOffset = sizeof(Header) + getPaddedKeySize(keySize);
+
+    if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0
+        || header.version != formatVersion
+        || header.valueSize != valueSize
+        || header.buildHash != getBuildHash()
+        || header.keySize != keySize
+        || size < payloadOffset
+        || std::memcmp(data + sizeof(Header), key.toRawUTF8(), keySize) != 0)
+        return nullptr;
+
+    auto payloadSize = size - payloadOffset;
+
+    if (header.numValues * valueSize != payloadSize
+        || header.checksum != hashBytes(data + payloadOffset, payloadSize))
+        return nullptr;
+
+    return mapped;
+}
+
+/*
+ Writes through a temporary file, so another instance mapping the same table never sees it half written.
+ Failing to write only means the table gets generated again next time.
+ */
+void TableCache::write(const juce::File& file, const juce::String& key,
+                       const void* values, size_t numValues, size_t valueSize)
+{
+    if (! file.getParentDirectory().createDirectory())
+        return;
+
+    Header header {};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = formatVersion;
+    header.valueSize = (juce::uint32)valueSize;
+    header.keySize = (juce::uint32)key.getNumBytesAsUTF8();
+    header.buildHash = getBuildHash();
+    header.numValues = numValues;
+    header.checksum = hashBytes(values, numValues * valueSize);
+
+    juce::MemoryBlock contents(&header, sizeof(Header));
+    contents.append(key.toRawUTF8(), header.keySize);
+    contents.setSize(sizeof(Header) + getPaddedKeySize(header.keySize), true);
+    contents.append(values, numValues * valueSize);
+    file.replaceWithData(contents.getData(), contents.getSize());
+}
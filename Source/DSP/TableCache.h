@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    TableCache.h
+    Created: 19 Oct 2026 4:05:19pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ A generated table, either mapped straight out of the on-disk cache or freshly generated when the cache had nothing usable
+ */
+template <typename ValueType>
+class CachedTable
+{
+public:
+    const ValueType* data() const { return values; }
+    size_t size() const { return numValues; }
+    bool wasLoadedFromDisk() const { return mappedFile != nullptr; }
+
+private:
+    friend class TableCache;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    std::vector<ValueType> generated;
+    const ValueType* values = nullptr;
+    size_t numValues = 0;
+};
+
+/*
+ Persists generated tables (coefficient banks, lookup tables...) between plugin loads. Each file starts with a header carrying
+ a format version, the build it was written by and a checksum of the payload, followed by the full key the table was
+ generated for. The file name only holds a hash of the key, so the key itself is what decides whether a file really is
+ the table asked for. Anything stale, damaged or colliding is simply regenerated and written again.
+ Only call this from prepare(), it touches the disk.
+ */
+class TableCache
+{
+public:
+    static constexpr juce::uint32 formatVersion = 2;
+
+    /*
+     Maps the table stored under key, or builds it with generate() (which returns a std::vector<ValueType>) and stores it.
+     The key has to describe everything the table depends on, e.g. sample rate and settings.
+     */
+    template <typename ValueType, typename Generator>
+    static std::shared_ptr<const CachedTable<ValueType>> load (const juce::String& key, Generator&& generate)
+    {
+        static_assert(std::is_trivially_copyable<ValueType>::value, "only plain values can be cached");
+
+        auto table = std::make_shared<CachedTable<ValueType>>();
+        auto file = getFileFor(key);
+
+        size_t payloadOffset = 0;
+        if (auto mapped = mapIfValid(file, key, sizeof(ValueType), payloadOffset))
+        {
+            table->values = reinterpret_cast<const ValueType*>(static_cast<const char*>(mapped->getData()) + payloadOffset);
+            table->numValues = (mapped->getSize() - payloadOffset) / sizeof(ValueType);
+            table->mappedFile = std::move(mapped);
+            return table;
+        }
+
+        table->generated = generate();
+        table->values = table->generated.data();
+        table->numValues = table->generated.size();
+        write(file, key, table->values, table->numValues, sizeof(ValueType));
+        return table;
+    }
+
+    static juce::File getCacheDirectory();
+
+private:
+    // followed by the UTF-8 key, zero padded to a multiple of 8 bytes so the payload after it stays 8 byte aligned
+    struct Header
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::uint32 valueSize;
+        juce::uint32 keySize;
+        juce::uint64 buildHash;
+        juce::uint64 numValues;
+        juce::uint64 checksum;
+    };
+
+    static juce::File getFileFor (const juce::String& key);
+    static juce::uint64 getBuildHash();
+    static juce::uint64 hashBytes (const void* data, size_t numBytes);
+    static size_t getPaddedKeySize (size_t keySize) { return (keySize + 7) & ~(size_t)7; }
+    static std::unique_ptr<juce::MemoryMappedFile> mapIfValid (const juce::File& file, const juce::String& key,
+                                                               size_t valueSize, size_t& payloadOffset);
+    static void write (const juce::File& file, const juce::String& key,
+                       const void* values, size_t numValues, size_t valueSize);
+};
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    TimingStats.h
+    Created: 19 Oct 2026 2:31:05pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ Running wall-clock figures for one kind of call, in microseconds. Written by whichever thread makes the call,
+ readable from any other.
+ */
+struct TimingStatistic
+{
+    void addMeasurement (double microseconds)
+    {
+        auto count = numMeasurements.fetch_add(1) + 1;
+        lastMicroseconds.store(microseconds);
+        averageMicroseconds.store(averageMicroseconds.load() + (microseconds - averageMicroseconds.load()) / (double)count);
+        if (microseconds > peakMicroseconds.load())
+            peakMicroseconds.store(microseconds);
+    }
+
+    double getLastMicroseconds() const { return lastMicroseconds.load(); }
+    double getAverageMicroseconds() const { return averageMicroseconds.load(); }
+    double getPeakMicroseconds() const { return peakMicroseconds.load(); }
+    int getNumMeasurements() const { return numMeasurements.load(); }
+
+private:
+    std::atomic<double> lastMicroseconds {0.0}, averageMicroseconds {0.0}, peakMicroseconds {0.0};
+    std::atomic<int> numMeasurements {0};
+};
+
+/*
+ Adds the time between construction and destruction to a TimingStatistic
+ */
+struct ScopedTimingMeasurement
+{
+    explicit ScopedTimingMeasurement (TimingStatistic& s) : statistic(s), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+    ~ScopedTimingMeasurement()
+    {
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        statistic.addMeasurement(elapsed * 1.0e6);
+    }
+
+private:
+    TimingStatistic& statistic;
+    juce::int64 startTicks;
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedTimingMeasurement)
+};
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+    Created: 19 Oct 2026 7:14:08pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+/*
+ Hands whole frames of data from one writer thread to one reader thread without either ever waiting.
+ The writer always has a buffer of its own to fill, the reader always has a complete one to look at,
+ and the third sits in the middle holding the latest published frame.
+ */
+template <typename FrameType>
+class TripleBuffer
+{
+public:
+    // writer side
+    FrameType& getWriteBuffer() { return buffers[(size_t)writeIndex]; }
+
+    void publish()
+    {
+        writeIndex = middle.exchange(writeIndex | freshFlag) & indexMask;
+    }
+
+    // reader side: swaps in the latest frame, returns false if nothing new was published since the last call
+    bool fetch()
+    {
+        if ((middle.load() & freshFlag) == 0)
+            return false;
+
+        readIndex = middle.exchange(readIndex) & indexMask;
+        return true;
+    }
+
+    const FrameType& getReadBuffer() const { return buffers[(size_t)readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<FrameType, 3> buffers {};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle {2};
+};
@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    WorkerPool.cpp
+    Created: 19 Oct 2026 5:40:16pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <semaphore.h>
+#endif
+
+#if JUCE_MAC || JUCE_IOS
+struct WorkerPool::WakeSignal::Impl
+{
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
+    ~Impl() { dispatch_release(semaphore); }
+    void signal() { dispatch_semaphore_signal(semaphore); }
+    void wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+};
+#elif JUCE_WINDOWS
+struct WorkerPool::WakeSignal::Impl
+{
+    HANDLE semaphore = CreateSemaphoreW(nullptr, 0, 1, nullptr);
+    ~Impl() { CloseHandle(semaphore); }
+    void signal() { ReleaseSemaphore(semaphore, 1, nullptr); }
+    void wait() { WaitForSingleObject(semaphore, INFINITE); }
+};
+#else
+struct WorkerPool::WakeSignal::Impl
+{
+    sem_t semaphore;
+    Impl() { sem_init(&semaphore, 0, 0); }
+    ~Impl() { sem_destroy(&semaphore); }
+    void signal() { sem_post(&semaphore); }
+    void wait() { while (sem_wait(&semaphore) != 0 && errno == EINTR) {} }
+};
+#endif
+
+WorkerPool::WakeSignal::WakeSignal() : impl(std::make_unique<Impl>()) {}
+WorkerPool::WakeSignal::~WakeSignal() = default;
+void WorkerPool::WakeSignal::signal() { impl->signal(); }
+void WorkerPool::WakeSignal::wait() { impl->wait(); }
+
+WorkerPool::WorkerPool(int numWorkers)
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<Worker>(*this, i));
+        workers.back()->startRealtimeThread(juce::Thread::RealtimeOptions{});
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    // a new generation makes sure a worker about to sleep notices, the way a dispatch would
+    for (auto& worker : workers)
+        worker->signalThreadShouldExit();
+    generation.fetch_add(2);
+
+    for (auto& worker : workers)
+        wakeIfSleeping(*worker);
+
+    for (auto& worker : workers)
+        worker->stopThread(1000);
+}
+
+/*
+ Audio thread side: publishes the jobs, lends a hand, then waits for the rest
+ */
+void WorkerPool::dispatch(int numJobs, JobFunction function, void* context)
+{
+    // keep workers out while the job is set up, and let any straggler from the last one leave
+    generation.fetch_add(1);
+    while (activeWorkers.load() != 0)
+        juce::Thread::yield();
+
+    jobFunction = function;
+    jobContext = context;
+    totalJobs = numJobs;
+    jobsRemaining.store(numJobs);
+    nextJob.store(0);
+    generation.fetch_add(1);
+
+    for (auto& worker : workers)
+        wakeIfSleeping(*worker);
+
+    runJobs();
+
+    for (int spins = 0; jobsRemaining.load() > 0; ++spins)
+        if (spins > spinsBeforeYielding)
+            juce::Thread::yield();
+}
+
+void WorkerPool::wakeIfSleeping(Worker& worker)
+{
+    if (worker.sleeping.exchange(false))
+        worker.wake.signal();
+}
+
+void WorkerPool::runJobs()
+{
+    for (;;)
+    {
+        auto index = nextJob.fetch_add(1);
+        if (index >= totalJobs)
+            return;
+
+        jobFunction(jobContext, index);
+        jobsRemaining.fetch_sub(1);
+    }
+}
+
+void WorkerPool::workerLoop(Worker& worker)
+{
+    juce::ScopedNoDenormals noDenormals;
+    auto seen = generation.load();
+    int spins = 0;
+
+    while (!worker.threadShouldExit())
+    {
+        auto current = generation.load();
+
+        if (current == seen || (current & 1) != 0)
+        {
+            if (++spins < spinsBeforeSleeping)
+                continue;
+
+            // checked again after raising the flag, so a dispatch either sees the flag or this sees the dispatch.
+            // If the dispatch got to the flag first its signal is on the way, and is taken here so none is left over
+            worker.sleeping.store(true);
+            if (generation.load() == seen || !worker.sleeping.exchange(false))
+                worker.wake.wait();
+            spins = 0;
+            continue;
+        }
+
+        activeWorkers.fetch_add(1);
+        if (generation.load() == current)
+        {
+            runJobs();
+            seen = current;
+        }
+        activeWorkers.fetch_sub(1);
+        spins = 0;
+    }
+}
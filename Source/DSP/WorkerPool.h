@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    WorkerPool.h
+    Created: 19 Oct 2026 5:40:16pm
+    Author:  Deanna Turner
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+/*
+ A small set of pre-spawned realtime threads the audio thread can hand jobs to. Handing out jobs and waiting for them
+ never allocates or takes a lock: jobs are claimed from an atomic counter, idle workers spin for a moment before going
+ to sleep, and the audio thread spins (then yields) until the last job is done.
+ Sleeping workers wait on a counting semaphore rather than a juce::WaitableEvent, whose notify() locks a mutex the
+ sleeper also uses. Posting the semaphore shares no lock with anyone, it is a single atomic when nobody waits on it
+ and one kernel wake-up when somebody does, and only happens for workers that went to sleep after the pool sat idle.
+ Create and destroy the pool from the message thread.
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool (int numWorkers);
+    ~WorkerPool();
+
+    int getNumWorkers() const { return (int)workers.size(); }
+
+    /*
+     Calls job(index) for every index in [0, numJobs), spread over the workers and the calling thread.
+     Returns once every job has finished. job has to stay alive until then, which it does as a local.
+     */
+    template <typename Job>
+    void run (int numJobs, Job& job)
+    {
+        if (numJobs <= 1 || workers.empty())
+        {
+            for (int i = 0; i < numJobs; ++i)
+                job(i);
+            return;
+        }
+
+        dispatch(numJobs, &invokeJob<Job>, &job);
+    }
+
+private:
+    using JobFunction = void (*) (void*, int);
+
+    template <typename Job>
+    static void invokeJob (void* job, int index) { (*static_cast<Job*>(job))(index); }
+
+    // the platform's own semaphore, whichever one it has that signals without a lock
+    struct WakeSignal
+    {
+        WakeSignal();
+        ~WakeSignal();
+        void signal();
+        void wait();
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+
+        JUCE_DECLARE_NON_COPYABLE (WakeSignal)
+    };
+
+    struct Worker : juce::Thread
+    {
+        Worker (WorkerPool& p, int index) : juce::Thread("tSaturator worker " + juce::String(index)), pool(p) {}
+        void run() override { pool.workerLoop(*this); }
+
+        WorkerPool& pool;
+        // whoever flips this back to false owes the worker exactly one signal
+        std::atomic<bool> sleeping {false};
+        WakeSignal wake;
+    };
+
+    void wakeIfSleeping (Worker& worker);
+
+    void dispatch (int numJobs, JobFunction function, void* context);
+    void workerLoop (Worker& worker);
+    void runJobs();
+
+    static constexpr int spinsBeforeSleeping = 4000;
+    static constexpr int spinsBeforeYielding = 1000;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // an odd generation means a dispatch is being set up, workers only pick up even ones
+    std::atomic<juce::uint32> generation {0};
+    std::atomic<int> activeWorkers {0};
+
+    JobFunction jobFunction = nullptr;
+    void* jobContext = nullptr;
+    int totalJobs = 0;
+    std::atomic<int> nextJob {0};
+    std::atomic<int> jobsRemaining {0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool)
+};
@@ -0,0 +1,51 @@
+//
+//  CachedLayer.hpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+ A picture of something that only changes with its size, like a grid or a knob face. It gets rendered into an image
+ at the display's physical pixel scale and after that draw() only blits it, until the area or the scale changes.
+ */
+class CachedLayer
+{
+public:
+    template <typename Renderer>
+    void draw(juce::Graphics& g, juce::Rectangle<int> area, Renderer&& render)
+    {
+        if (area.isEmpty())
+            return;
+
+        auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        if (image.isNull() || area != renderedArea || scale != renderedScale)
+        {
+            renderedArea = area;
+            renderedScale = scale;
+            image = juce::Image(juce::Image::ARGB,
+                                juce::jmax(1, juce::roundToInt((float)area.getWidth() * scale)),
+                                juce::jmax(1, juce::roundToInt((float)area.getHeight() * scale)),
+                                true);
+
+            // the renderer draws in the same coordinates it would use on g
+            juce::Graphics layer(image);
+            layer.addTransform(juce::AffineTransform::translation((float)-area.getX(), (float)-area.getY())
+                                                     .scaled(scale));
+            render(layer);
+        }
+
+        g.drawImage(image, area.toFloat());
+    }
+
+    // for when what's drawn changes without the size changing
+    void invalidate() { image = juce::Image(); }
+private:
+    juce::Image image;
+    juce::Rectangle<int> renderedArea;
+    float renderedScale = 0.f;
+};
@@ -0,0 +1,124 @@
+//
+//  Goniometer.cpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#include "Goniometer.hpp"
+#include "LookAndFeel.hpp"
+
+Goniometer::Goniometer(StereoScope& scopeRef) : scope(scopeRef)
+{
+    scope.setFeeding(true);
+}
+
+Goniometer::~Goniometer()
+{
+    scope.setFeeding(false);
+}
+
+juce::Rectangle<int> Goniometer::getTraceArea() const
+{
+    auto bounds = getLocalBounds().reduced(6);
+    bounds.removeFromBottom(correlationBarHeight + 4);
+    auto side = juce::jmin(bounds.getWidth(), bounds.getHeight());
+    return bounds.withSizeKeepingCentre(side, side);
+}
+
+void Goniometer::resized()
+{
+    auto area = getTraceArea();
+    trace = area.isEmpty() ? juce::Image() : juce::Image(juce::Image::ARGB, area.getWidth(), area.getHeight(), true);
+}
+
+bool Goniometer::renderFrame()
+{
+    auto previousCorrelation = shownCorrelation;
+    shownCorrelation += correlationSmoothing * (scope.getCorrelation() - shownCorrelation);
+
+    auto numPoints = scope.readPoints(pointLeft, pointRight, StereoScope::ringSize);
+    framesSinceSignal = hasSignal(numPoints) ? 0 : juce::jmin(framesSinceSignal + 1, fadeOutFrames);
+
+    auto tracing = framesSinceSignal < fadeOutFrames;
+    if (tracing && trace.isValid())
+    {
+        // fading the whole image is what turns the old points into a trail
+        trace.multiplyAllAlphas(fadePerFrame);
+        plotPoints(numPoints);
+    }
+
+    auto changed = tracing || std::abs(shownCorrelation - previousCorrelation) > 1.0e-3f;
+    if (changed)
+        repaint();
+    return changed;
+}
+
+// silence would otherwise keep plotting the centre pixel and never let the trace go idle
+bool Goniometer::hasSignal(int numPoints) const
+{
+    constexpr float floor = 1.0e-4f;
+    for (const auto* points : { pointLeft, pointRight })
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(points, numPoints);
+        if (range.getStart() < -floor || range.getEnd() > floor)
+            return true;
+    }
+
+    return false;
+}
+
+void Goniometer::plotPoints(int numPoints)
+{
+    auto size = trace.getWidth();
+    auto half = (float)size * 0.5f;
+    // full scale on one channel lands on the L or R diagonal half the square's width from the centre, on the circle
+    // that touches the edges rather than in the corner. Mid is L + R, so full scale mono would be sqrt 2 times that
+    // far up and gets clipped at the top edge, anything up to -3 dBFS mono still fits
+    auto scale = half * juce::MathConstants<float>::sqrt2 * 0.5f;
+    auto colour = TSPalette::getGoniometerTraceColor();
+
+    juce::Image::BitmapData pixels(trace, juce::Image::BitmapData::readWrite);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto side = pointRight[i] - pointLeft[i];
+        auto mid = pointLeft[i] + pointRight[i];
+        auto x = juce::roundToInt(half + side * scale);
+        auto y = juce::roundToInt(half - mid * scale);
+
+        if (x >= 0 && x < size && y >= 0 && y < size)
+            pixels.setPixelColour(x, y, colour);
+    }
+}
+
+void Goniometer::paint(juce::Graphics& g)
+{
+    g.setColour(TSPalette::getAnalysisAreaBackgroundColor());
+    g.fillRect(getLocalBounds().reduced(3));
+
+    auto area = getTraceArea().toFloat();
+    g.setColour(TSPalette::getGridlineColor().withAlpha(0.3f));
+    g.drawLine(area.getCentreX(), area.getY(), area.getCentreX(), area.getBottom());
+    g.drawLine(area.getX(), area.getY(), area.getRight(), area.getBottom());
+    g.drawLine(area.getRight(), area.getY(), area.getX(), area.getBottom());
+
+    g.setFont(10);
+    g.setColour(TSPalette::getToggleButtonTextColor());
+    g.drawText("L", area.removeFromTop(12).removeFromLeft(12), juce::Justification::centred);
+    g.drawText("R", getTraceArea().toFloat().removeFromTop(12).removeFromRight(12), juce::Justification::centred);
+
+    if (trace.isValid())
+        g.drawImageAt(trace, getTraceArea().getX(), getTraceArea().getY());
+
+    // -1 on the left, +1 on the right, with the marker red while the channels are out of phase
+    auto bar = getLocalBounds().reduced(6).removeFromBottom(correlationBarHeight).toFloat();
+    g.setColour(TSPalette::getGridlineColor().withAlpha(0.15f));
+    g.fillRect(bar);
+    g.setColour(TSPalette::getGridlineColor().withAlpha(0.5f));
+    g.drawVerticalLine((int)bar.getCentreX(), bar.getY(), bar.getBottom());
+
+    auto markerX = juce::jmap(shownCorrelation, -1.f, 1.f, bar.getX(), bar.getRight());
+    g.setColour(shownCorrelation < 0.f ? juce::Colours::red : TSPalette::getGoniometerTraceColor());
+    g.fillRect(juce::Rectangle<float>(markerX - 2.f, bar.getY(), 4.f, bar.getHeight()));
+}
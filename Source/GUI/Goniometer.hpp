@@ -0,0 +1,46 @@
+//
+//  Goniometer.hpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../DSP/StereoScope.h"
+#include "RenderScheduler.hpp"
+
+/*
+ Draws a StereoScope: mid/side goniometer on top, correlation bar underneath.
+ Points are plotted straight into an image that is kept between frames and faded a little every tick,
+ so each frame only touches the points that arrived since the last one.
+ */
+class Goniometer : public juce::Component, public RenderScheduler::Client
+{
+public:
+    explicit Goniometer(StereoScope& scopeRef);
+    ~Goniometer() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    // repaints while points arrive or the trail is still fading out, and when the correlation moves
+    bool renderFrame() override;
+private:
+    void plotPoints(int numPoints);
+    bool hasSignal(int numPoints) const;
+    juce::Rectangle<int> getTraceArea() const;
+
+    static constexpr float fadePerFrame = 0.85f;
+    static constexpr int fadeOutFrames = 35;    // 0.85^35 is below one step of alpha
+    static constexpr float correlationSmoothing = 0.2f;
+    static constexpr int correlationBarHeight = 14;
+
+    StereoScope& scope;
+    juce::Image trace;
+    float pointLeft[StereoScope::ringSize] = {};
+    float pointRight[StereoScope::ringSize] = {};
+    float shownCorrelation = 0.f;
+    int framesSinceSignal = fadeOutFrames;
+};
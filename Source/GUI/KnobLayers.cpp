@@ -0,0 +1,52 @@
+//
+//  KnobLayers.cpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#include "KnobLayers.hpp"
+#include "LookAndFeel.hpp"
+
+SharedResources::Ptr<KnobLayers> KnobLayers::get(LookAndFeel& lnf, const Style& style)
+{
+    return SharedResources::get<KnobLayers>("image/knob/" + SharedResources::describe(style), [&]
+    {
+        auto sliderBounds = style.getSliderBounds();
+        auto layers = std::make_shared<KnobLayers>();
+        layers->scale = style.scale;
+        layers->pivot = sliderBounds.getCentre();
+
+        layers->face = juce::Image(juce::Image::ARGB,
+                                   juce::jmax(1, juce::roundToInt((float)style.width * style.scale)),
+                                   juce::jmax(1, juce::roundToInt((float)style.height * style.scale)),
+                                   true);
+        {
+            juce::Graphics g(layers->face);
+            g.addTransform(juce::AffineTransform::scale(style.scale));
+            lnf.drawRotaryKnobFace(g, sliderBounds, style.rotaryStartAngle, style.rotaryEndAngle, style.numMinorTicksPerGap);
+        }
+
+        // a pixel of margin so the rounded ends keep their antialiasing
+        auto pointerArea = LookAndFeel::getRotaryKnobPointerArea(sliderBounds, (float)style.textHeight).expanded(1.f);
+        layers->pointerOrigin = pointerArea.getTopLeft();
+        layers->pointer = juce::Image(juce::Image::ARGB,
+                                      juce::jmax(1, (int)std::ceil(pointerArea.getWidth() * style.scale)),
+                                      juce::jmax(1, (int)std::ceil(pointerArea.getHeight() * style.scale)),
+                                      true);
+        {
+            juce::Graphics g(layers->pointer);
+            g.addTransform(juce::AffineTransform::translation(-pointerArea.getX(), -pointerArea.getY()).scaled(style.scale));
+            lnf.drawRotaryKnobPointer(g, sliderBounds, 0.f, (float)style.textHeight);
+        }
+
+        return std::shared_ptr<const KnobLayers>(std::move(layers));
+    });
+}
+
+juce::AffineTransform KnobLayers::getPointerTransform(float angle) const
+{
+    return juce::AffineTransform::scale(1.f / scale)
+        .translated(pointerOrigin.getX(), pointerOrigin.getY())
+        .rotated(angle, pivot.getX(), pivot.getY());
+}
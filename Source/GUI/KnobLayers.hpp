@@ -0,0 +1,55 @@
+//
+//  KnobLayers.hpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../DSP/SharedResources.h"
+
+struct LookAndFeel;
+
+/*
+ One knob style pre-rendered at one size and display scale: the face with its ring and ticks, and the pointer at rest.
+ Painting a knob is then a blit of the face and one rotated blit of the pointer. Knobs that look the same share
+ a set through SharedResources, in this editor and in any other open one.
+ */
+struct KnobLayers
+{
+    /*
+     Everything the pictures depend on, as plain data so it can be turned into a key. The look and feel isn't in it:
+     there is only the one, and it takes its colours from TSPalette, so it draws the same for the same style.
+     */
+    struct Style
+    {
+        int width = 0, height = 0;
+        float boundsX = 0.f, boundsY = 0.f, boundsWidth = 0.f, boundsHeight = 0.f;    // the slider area in the knob
+        float rotaryStartAngle = 0.f, rotaryEndAngle = 0.f;
+        int numMinorTicksPerGap = 1;
+        int textHeight = 14;
+        float scale = 1.f;
+
+        juce::Rectangle<float> getSliderBounds() const { return { boundsX, boundsY, boundsWidth, boundsHeight }; }
+
+        bool operator!= (const Style& other) const
+        {
+            return width != other.width || height != other.height
+                || getSliderBounds() != other.getSliderBounds()
+                || rotaryStartAngle != other.rotaryStartAngle || rotaryEndAngle != other.rotaryEndAngle
+                || numMinorTicksPerGap != other.numMinorTicksPerGap
+                || textHeight != other.textHeight || scale != other.scale;
+        }
+    };
+
+    static SharedResources::Ptr<KnobLayers> get(LookAndFeel& lnf, const Style& style);
+
+    // where the pointer sprite goes to point at angle, in the knob's own coordinates
+    juce::AffineTransform getPointerTransform(float angle) const;
+
+    juce::Image face, pointer;
+    juce::Point<float> pointerOrigin, pivot;
+    float scale = 1.f;
+};
@@ -95,9 +95,17 @@ void KnobPanel::resized()
     flexBox.items.add(horizontalSpacerOne);
     
     flexBox.performLayout(bounds);
+    // the knob titles follow the knobs, which can move without the panel changing size
+    staticLayer.invalidate();
 }
 
 void KnobPanel::paint(juce::Graphics &g)
+{
+    // nothing in here moves with the knobs, so it's only drawn again after a resize
+    staticLayer.draw(g, getLocalBounds(), [this](juce::Graphics& layer) { drawStaticLayer(layer); });
+}
+
+void KnobPanel::drawStaticLayer(juce::Graphics &g)
 {
     using namespace juce;
     auto bounds = getLocalBounds();
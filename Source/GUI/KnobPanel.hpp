@@ -9,6 +9,7 @@
 
 #include <JuceHeader.h>
 #include "RotaryKnob.hpp"
+#include "CachedLayer.hpp"
 
 /*
  Struct that holds all knobs on the interface. This class is only a listener so that it can redraw the text under the knobs
@@ -28,5 +29,8 @@ private:
     using Attachment = APVTS::SliderAttachment;
     
     Attachment saturationKnobAttachment, driveKnobAttachment, mixKnobAttachment, hissKnobAttachment;
+    
+    void drawStaticLayer(juce::Graphics& g);
+    CachedLayer staticLayer;
 };
 
@@ -0,0 +1,115 @@
+//
+//  LevelMeterDisplay.cpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#include "LevelMeterDisplay.hpp"
+#include "LookAndFeel.hpp"
+
+LevelMeterDisplay::LevelMeterDisplay(LevelMeter& meterRef, const juce::String& meterTitle) :
+meter(meterRef),
+title(meterTitle)
+{
+}
+
+bool LevelMeterDisplay::renderFrame()
+{
+    auto& readings = meter.getReadings();
+    // the scheduler drops to its idle rate when nothing moves, so the fall goes by the time that actually passed
+    auto now = juce::Time::getMillisecondCounterHiRes();
+    auto elapsedSeconds = lastFrameMs > 0.0 ? (now - lastFrameMs) / 1000.0 : 1.0 / refreshRateHz;
+    lastFrameMs = now;
+    auto fall = peakFallDBPerSecond * (float)elapsedSeconds;
+    auto changed = false;
+
+    auto show = [&changed](float& shown, float value)
+    {
+        changed = changed || value != shown;
+        shown = value;
+    };
+
+    for (int ch = 0; ch < MeterReadings::numChannels; ++ch)
+    {
+        show(shownPeak[ch], juce::jmax(readings.takeSamplePeak(ch), shownPeak[ch] - fall, minMeterDB));
+        show(shownRms[ch], juce::jmax(readings.getRms(ch), minMeterDB));
+        show(maxTruePeak, juce::jmax(maxTruePeak, readings.takeTruePeak(ch)));
+    }
+
+    show(shortTerm, readings.getShortTermLoudness());
+    show(integrated, readings.getIntegratedLoudness());
+
+    if (changed)
+        repaint();
+    return changed;
+}
+
+void LevelMeterDisplay::mouseDown(const juce::MouseEvent&)
+{
+    maxTruePeak = MeterReadings::minusInfinityDb;
+    meter.resetIntegrated();
+    repaint();
+}
+
+juce::Rectangle<int> LevelMeterDisplay::getBarArea() const
+{
+    auto bounds = getLocalBounds().reduced(6, 0);
+    bounds.removeFromTop(16);
+    bounds.removeFromBottom(42);
+    return bounds;
+}
+
+float LevelMeterDisplay::dBToY(float dB, juce::Rectangle<int> area) const
+{
+    return juce::jmap(juce::jlimit(minMeterDB, maxMeterDB, dB), minMeterDB, maxMeterDB,
+                      (float)area.getBottom(), (float)area.getY());
+}
+
+void LevelMeterDisplay::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds();
+    g.setColour(TSPalette::getAnalysisAreaBackgroundColor());
+    g.fillRect(bounds.reduced(3));
+
+    g.setColour(TSPalette::getToggleButtonTextColor());
+    g.setFont(11);
+    g.drawText(title, bounds.removeFromTop(16), juce::Justification::centred);
+
+    auto barArea = getBarArea();
+    auto barWidth = (barArea.getWidth() - 4) / 2;
+
+    for (int ch = 0; ch < MeterReadings::numChannels; ++ch)
+    {
+        auto bar = juce::Rectangle<int>(barArea.getX() + ch * (barWidth + 4), barArea.getY(), barWidth, barArea.getHeight());
+        auto colour = ch == 0 ? TSPalette::getLeftChannelColor() : TSPalette::getRightChannelColor();
+
+        g.setColour(colour.withAlpha(0.15f));
+        g.fillRect(bar);
+
+        auto rmsTop = dBToY(shownRms[ch], bar);
+        g.setColour(colour);
+        g.fillRect(juce::Rectangle<float>((float)bar.getX(), rmsTop, (float)bar.getWidth(), (float)bar.getBottom() - rmsTop));
+
+        // anything over 0 dBFS shows up red
+        g.setColour(shownPeak[ch] > 0.f ? juce::Colours::red : juce::Colours::white);
+        g.drawHorizontalLine((int)dBToY(shownPeak[ch], bar), (float)bar.getX(), (float)bar.getRight());
+    }
+
+    g.setColour(TSPalette::getGridlineColor().withAlpha(0.5f));
+    g.drawHorizontalLine((int)dBToY(0.f, barArea), (float)barArea.getX(), (float)barArea.getRight());
+
+    auto format = [](float value)
+    {
+        return value <= MeterReadings::minusInfinityDb ? juce::String("-inf") : juce::String(value, 1);
+    };
+
+    auto text = bounds.removeFromBottom(42).reduced(4, 2);
+    auto lineHeight = text.getHeight() / 3;
+    g.setFont(10);
+    g.setColour(maxTruePeak > 0.f ? juce::Colours::red : TSPalette::getToggleButtonTextColor());
+    g.drawText("TP " + format(maxTruePeak), text.removeFromTop(lineHeight), juce::Justification::centredLeft);
+    g.setColour(TSPalette::getToggleButtonTextColor());
+    g.drawText("S " + format(shortTerm), text.removeFromTop(lineHeight), juce::Justification::centredLeft);
+    g.drawText("I " + format(integrated), text.removeFromTop(lineHeight), juce::Justification::centredLeft);
+}
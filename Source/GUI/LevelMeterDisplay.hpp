@@ -0,0 +1,46 @@
+//
+//  LevelMeterDisplay.hpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../DSP/LevelMeter.h"
+#include "RenderScheduler.hpp"
+
+/*
+ Draws one LevelMeter: an RMS bar with a falling peak line per channel, and the highest true peak,
+ short-term and integrated loudness as text underneath. Clicking it starts the max true peak and integrated loudness over.
+ */
+class LevelMeterDisplay : public juce::Component, public RenderScheduler::Client
+{
+public:
+    LevelMeterDisplay(LevelMeter& meterRef, const juce::String& meterTitle);
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& e) override;
+
+    // repaints only when one of the shown values moved, so a silent meter costs nothing
+    bool renderFrame() override;
+
+    static constexpr int refreshRateHz = 30;
+private:
+    juce::Rectangle<int> getBarArea() const;
+    float dBToY(float dB, juce::Rectangle<int> area) const;
+
+    static constexpr float minMeterDB = -60.f;
+    static constexpr float maxMeterDB = 6.f;
+    static constexpr float peakFallDBPerSecond = 20.f;
+
+    LevelMeter& meter;
+    juce::String title;
+    float shownPeak[MeterReadings::numChannels] { minMeterDB, minMeterDB };
+    float shownRms[MeterReadings::numChannels] { minMeterDB, minMeterDB };
+    float maxTruePeak = MeterReadings::minusInfinityDb;
+    float shortTerm = MeterReadings::minusInfinityDb;
+    float integrated = MeterReadings::minusInfinityDb;
+    double lastFrameMs = 0.0;
+};
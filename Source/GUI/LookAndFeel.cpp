@@ -17,11 +17,28 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g,
                                    float rotaryStartAngle,
                                    float rotaryEndAngle,
                                    juce::Slider & slider)
+{
+    auto bounds = juce::Rectangle<float>(x, y, width, height);
+    auto* knob = dynamic_cast<RotaryKnob*>(&slider);
+    drawRotaryKnobFace(g, bounds, rotaryStartAngle, rotaryEndAngle, knob != nullptr ? knob->getMinorTicksPerGap() : 1);
+    
+    if (knob != nullptr)
+    {
+        jassert(rotaryStartAngle < rotaryEndAngle);
+        auto sliderAngRad = juce::jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+        drawRotaryKnobPointer(g, bounds, sliderAngRad, (float)knob->getTextHeight());
+    }
+}
+
+void LookAndFeel::drawRotaryKnobFace(juce::Graphics& g,
+                                     juce::Rectangle<float> bounds,
+                                     float rotaryStartAngle,
+                                     float rotaryEndAngle,
+                                     int numMinorTicksPerGap)
 {
     using namespace juce;
     
-    auto bounds = Rectangle<float>(x, y, width, height);
-    auto tickBoundingBox = Rectangle<float>(x, y, width, height).expanded(10);
+    auto tickBoundingBox = bounds.expanded(10);
     
     g.setColour(TSPalette::getInnerKnobColor());
     g.fillEllipse(bounds);
@@ -39,15 +56,6 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g,
     auto center = bounds.getCentre();
     auto tickRadius = bounds.getWidth() * 0.5f + 9.5f;
     const int numMajorTicks = 11;
-    int numMinorTicksPerGap = 1;
-    
-    // Drive knob should not have minor ticks
-    if (auto* knob = dynamic_cast<RotaryKnob*>(&slider))
-    {
-        juce::String title = knob->getKnobTitle();
-        if (title == "Drive")
-            numMinorTicksPerGap = 0;
-    }
     int totalTicks = (numMajorTicks - 1) * (numMinorTicksPerGap + 1) + 1;
 
     // JUCE starts drawing from 3 o'clock and not 12
@@ -67,29 +75,33 @@ void LookAndFeel::drawRotarySlider(juce::Graphics & g,
 
         g.drawLine({ tickStart, tickEnd }, 2.0f);
     }
+}
+
+juce::Rectangle<float> LookAndFeel::getRotaryKnobPointerArea(juce::Rectangle<float> bounds, float textHeight)
+{
+    auto center = bounds.getCentre();
     
-    if (auto* rk = dynamic_cast<RotaryKnob*>(&slider))
-    {
-        g.setColour(TSPalette::getLabelTicksAndTextColor());
-        auto center = bounds.getCentre();
-        Path p;
-        
-        Rectangle<float> r;
-        r.setLeft(center.getX() - 2);
-        r.setRight(center.getX() + 2);
-        r.setTop(bounds.getY());
-        r.setBottom(center.getY() - rk->getTextHeight() * 1.5);
-        
-        p.addRoundedRectangle(r, 2.f);
-        
-        jassert(rotaryStartAngle < rotaryEndAngle);
-        
-        auto sliderAngRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
-        
-        p.applyTransform(AffineTransform().rotated(sliderAngRad, center.getX(), center.getY()));
-        
-        g.fillPath(p);
-    }
+    juce::Rectangle<float> r;
+    r.setLeft(center.getX() - 2);
+    r.setRight(center.getX() + 2);
+    r.setTop(bounds.getY());
+    r.setBottom(center.getY() - textHeight * 1.5f);
+    return r;
+}
+
+void LookAndFeel::drawRotaryKnobPointer(juce::Graphics& g,
+                                        juce::Rectangle<float> bounds,
+                                        float angle,
+                                        float textHeight)
+{
+    using namespace juce;
+    
+    g.setColour(TSPalette::getLabelTicksAndTextColor());
+    auto center = bounds.getCentre();
+    Path p;
+    p.addRoundedRectangle(getRotaryKnobPointerArea(bounds, textHeight), 2.f);
+    p.applyTransform(AffineTransform().rotated(angle, center.getX(), center.getY()));
+    g.fillPath(p);
 }
 
 void LookAndFeel::drawToggleButton(juce::Graphics &g,
@@ -19,6 +19,8 @@ inline juce::Colour getKnobAreaBorderColor() { return juce::Colours::darkgrey; }
 inline juce::Colour getPluginBackgroundColor() { return juce::Colours::lightsteelblue; }
 inline juce::Colour getAnalysisAreaBackgroundColor() { return juce::Colours::black; }
 inline juce::Colour getToggleButtonTextColor() { return juce::Colours::white; }
+inline juce::Colour getDifferenceCurveColor() { return juce::Colours::orange; }
+inline juce::Colour getGoniometerTraceColor() { return juce::Colours::lightgreen; }
 }
 struct LookAndFeel : juce::LookAndFeel_V4
 {
@@ -29,6 +31,21 @@ struct LookAndFeel : juce::LookAndFeel_V4
                            float rotaryEndAngle,
                            juce::Slider&) override;
     
+    // the two halves of drawRotarySlider, so a knob can pre-render both and only rotate the pointer
+    void drawRotaryKnobFace (juce::Graphics& g,
+                             juce::Rectangle<float> bounds,
+                             float rotaryStartAngle,
+                             float rotaryEndAngle,
+                             int numMinorTicksPerGap);
+    
+    // the pointer at rest, pointing straight up
+    static juce::Rectangle<float> getRotaryKnobPointerArea (juce::Rectangle<float> bounds, float textHeight);
+    
+    void drawRotaryKnobPointer (juce::Graphics& g,
+                                juce::Rectangle<float> bounds,
+                                float angle,
+                                float textHeight);
+    
     void drawToggleButton (juce::Graphics &g,
                            juce::ToggleButton & toggleButton,
                            bool shouldDrawButtonAsHighlighted,
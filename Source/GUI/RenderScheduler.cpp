@@ -0,0 +1,42 @@
+//
+//  RenderScheduler.cpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#include "RenderScheduler.hpp"
+
+RenderScheduler::RenderScheduler(juce::Component& owner) :
+vblank(&owner, [this](double timestampSeconds) { onVBlank(timestampSeconds); })
+{
+}
+
+void RenderScheduler::addClient(Client& client, double maxRateHz)
+{
+    clients.push_back({ &client, 1.0 / maxRateHz, 0.0 });
+}
+
+void RenderScheduler::onVBlank(double timestampSeconds)
+{
+    auto idle = timestampSeconds - lastChange > idleAfterSeconds;
+    if (idle && timestampSeconds - lastFrame < 1.0 / idleRateHz)
+        return;
+
+    ScopedTimingMeasurement measurement(frameTiming);
+    lastFrame = timestampSeconds;
+
+    auto changed = false;
+    for (auto& entry : clients)
+    {
+        // a little slack so a 30 Hz client on a 60 Hz display doesn't miss every other slot to jitter
+        if (timestampSeconds - entry.lastFrame < entry.interval * 0.9)
+            continue;
+
+        entry.lastFrame = timestampSeconds;
+        changed = entry.client->renderFrame() || changed;
+    }
+
+    if (changed)
+        lastChange = timestampSeconds;
+}
@@ -0,0 +1,55 @@
+//
+//  RenderScheduler.hpp
+//  TapeSaturation
+//
+//  Created by Deanna Turner on 10/19/26.
+//
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../DSP/TimingStats.h"
+
+/*
+ The one clock behind everything that animates in the editor, run off the display's vblank instead of a timer per
+ component. Each client pulls its new data and repaints only itself, and only when something it shows changed.
+ Once no client has changed anything for a while (silence, paused analyzer) the frames drop to idleRateHz
+ until something changes again.
+ */
+class RenderScheduler
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+
+        // pull whatever is new and repaint if it changes what's on screen. Returns whether it did
+        virtual bool renderFrame() = 0;
+    };
+
+    explicit RenderScheduler(juce::Component& owner);
+
+    // clients are called in the order they were added, at most maxRateHz times a second
+    void addClient(Client& client, double maxRateHz);
+
+    // how long each frame that wasn't skipped for idling took
+    const TimingStatistic& getFrameTiming() const { return frameTiming; }
+private:
+    void onVBlank(double timestampSeconds);
+
+    static constexpr double idleRateHz = 10.0;
+    static constexpr double idleAfterSeconds = 0.5;
+
+    struct Entry
+    {
+        Client* client;
+        double interval;
+        double lastFrame;
+    };
+
+    std::vector<Entry> clients;
+    double lastChange = 0.0;
+    double lastFrame = 0.0;
+    TimingStatistic frameTiming;
+    juce::VBlankAttachment vblank;
+};
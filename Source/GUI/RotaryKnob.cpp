@@ -7,6 +7,7 @@
 
 #include "RotaryKnob.hpp"
 #include "Utilities.hpp"
+#include "LookAndFeel.hpp"
 
 void RotaryKnob::paint(juce::Graphics &g)
 {
@@ -23,18 +24,67 @@ void RotaryKnob::paint(juce::Graphics &g)
     knobFlexBox.maxWidth = 250;
     knobFlexBox.maxHeight = 270;
     
-    getLookAndFeel().drawRotarySlider(g,
-                                      sliderBounds.getX(),
-                                      sliderBounds.getY(),
-                                      sliderBounds.getWidth(),
-                                      sliderBounds.getHeight(),
-                                      static_cast<float>(jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0)),
-                                      startAng,
-                                      endAng,
-                                      *this);
+    auto sliderPos = static_cast<float>(jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0));
+    
+    // resolved here, since a knob picks up the editor's look and feel when it's added to it, and JUCE only calls
+    // lookAndFeelChanged() for setLookAndFeel() on the knob or its parents, not for a new parent
+    auto* currentLookAndFeel = dynamic_cast<::LookAndFeel*>(&getLookAndFeel());
+    if (currentLookAndFeel != knobLookAndFeel)
+    {
+        knobLookAndFeel = currentLookAndFeel;
+        layers = nullptr;
+    }
+    
+    // the face and pointer are pre-rendered, so a repaint is one blit and one rotated blit
+    if (knobLookAndFeel == nullptr)
+    {
+        // only a knob shown outside the editor (and so without its look and feel) should ever get here
+        jassert(findParentComponentOfClass<juce::AudioProcessorEditor>() == nullptr);
+
+        getLookAndFeel().drawRotarySlider(g,
+                                          sliderBounds.getX(),
+                                          sliderBounds.getY(),
+                                          sliderBounds.getWidth(),
+                                          sliderBounds.getHeight(),
+                                          sliderPos,
+                                          startAng,
+                                          endAng,
+                                          *this);
+        return;
+    }
+    
+    KnobLayers::Style style;
+    style.width = getWidth();
+    style.height = getHeight();
+    style.boundsX = (float)sliderBounds.getX();
+    style.boundsY = (float)sliderBounds.getY();
+    style.boundsWidth = (float)sliderBounds.getWidth();
+    style.boundsHeight = (float)sliderBounds.getHeight();
+    style.rotaryStartAngle = startAng;
+    style.rotaryEndAngle = endAng;
+    style.numMinorTicksPerGap = minorTicksPerGap;
+    style.textHeight = getTextHeight();
+    style.scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (layers == nullptr || style != layersStyle)
+    {
+        layersStyle = style;
+        layers = KnobLayers::get(*knobLookAndFeel, style);
+    }
+    
+    g.drawImage(layers->face, getLocalBounds().toFloat());
+    g.drawImageTransformed(layers->pointer, layers->getPointerTransform(jmap(sliderPos, startAng, endAng)));
     g.setFont(getTextHeight());
 }
 
+void RotaryKnob::lookAndFeelChanged()
+{
+    juce::Slider::lookAndFeelChanged();
+    // the old pictures belong to the old look and feel, paint() looks up the new one
+    knobLookAndFeel = nullptr;
+    layers = nullptr;
+}
+
 juce::Rectangle<int> RotaryKnob::getSliderBounds() const
 {
     auto bounds = getLocalBounds();
@@ -54,15 +104,8 @@ juce::String RotaryKnob::getDisplayString() const
 {
     juce::String str;
     
-    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
-    {
-        float val = getValue();
-        str = juce::String(val);
-    }
-    else
-    {
-        jassertfalse;
-    }
+    // the constructor made sure param is an AudioParameterFloat
+    str = juce::String((float)getValue());
     
     if (suffix.isNotEmpty())
     {
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "KnobLayers.hpp"
 
 /*
  Handles logic for each rotary knob on the interface
@@ -22,8 +23,12 @@ public:
                  juce::Slider::TextEntryBoxPosition::NoTextBox),
     param(&rap),
     suffix(unitSuffix),
-    title(title)
+    title(title),
+    // Drive knob should not have minor ticks
+    minorTicksPerGap(title == "Drive" ? 0 : 1)
     {
+        // getDisplayString() reads the value straight off the slider
+        jassert(dynamic_cast<juce::AudioParameterFloat*>(param) != nullptr);
         setName(title);
     }
     
@@ -41,12 +46,19 @@ public:
     juce::Array<LabelPos> labels;
     
     void paint(juce::Graphics& g) override;
+    void lookAndFeelChanged() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
     juce::String getKnobTitle() const { return this->title; }
+    int getMinorTicksPerGap() const { return minorTicksPerGap; }
 protected:
     juce::RangedAudioParameter* param;
     juce::String suffix;
     juce::String title;
+private:
+    int minorTicksPerGap;
+    ::LookAndFeel* knobLookAndFeel = nullptr;
+    KnobLayers::Style layersStyle;
+    SharedResources::Ptr<KnobLayers> layers;
 };
@@ -10,6 +10,8 @@
 #include <JuceHeader.h>
 #include "../DSP/FFTProcessing.h"
 #include "Utilities.hpp"
+#include "CachedLayer.hpp"
+#include "RenderScheduler.hpp"
 
 /* 
  This file contains code adapted from JUCE's official Spectrum Analyser tutorial. Under the terms of the ISC license
@@ -62,73 +64,159 @@ struct SpectrumAnalyzerUtils
 /*
  Render logic for drawing the L and R channels on the analyzer based on the FFT data processed by the application
  */
-class SpectrumAnalyzer : public juce::Component, private juce::Timer
+class SpectrumAnalyzer : public juce::Component, public RenderScheduler::Client
 {
 public:
+    enum class DisplayMode { Spectrum, Spectrogram, Difference };
+
     SpectrumAnalyzer(FFTAnalyzer& analyzerRef) : analyzer(analyzerRef)
     {
-        startTimerHz(60);
+        buildSpectrogramColourMap();
+        analyzer.setPaused(false);
+        analyzer.setAnalysisMode(FFTAnalyzer::AnalysisMode::FFT);
+        analyzer.setComparingInput(false);
+        analyzer.setQueueingSpectrogram(false);
+        analyzer.startAnalysis();
+    }
+
+    ~SpectrumAnalyzer() override
+    {
+        analyzer.stopAnalysis();
+    }
+
+    /*
+     Called by the editor's RenderScheduler. Only the analysis area is repainted, the labels around it never change.
+     Once the scope has settled on the floor the line modes drop silent frames. The spectrogram doesn't, its x axis is
+     time, so silence keeps scrolling in as floor coloured columns for as long as the host feeds audio.
+     */
+    bool renderFrame() override
+    {
+        if (!shouldShowFFTAnalysis)
+            return false;
+
+        // one column for every frame the analysis thread published, however many that was since the last repaint
+        if (displayMode == DisplayMode::Spectrogram)
+        {
+            if (analyzer.readSpectrogramColumns([this] (const juce::uint8* levels) { addSpectrogramColumn(levels); }) == 0)
+                return false;
+
+            repaint(getSpectrumArea());
+            return true;
+        }
+
+        if (!analyzer.pullLatestScope())
+            return false;
+
+        auto silent = isScopeSilent();
+        if (silent && showingSilence)
+            return false;
+        showingSilence = silent;
+
+        repaint(getSpectrumArea());
+        return true;
     }
 
-    void timerCallback() override
+    void resized() override
     {
-        if (shouldShowFFTAnalysis)
+        auto area = getSpectrumArea();
+        spectrogram = juce::Image(juce::Image::RGB, juce::jmax(1, area.getWidth()), juce::jmax(1, area.getHeight()), true);
+        spectrogramColumn = 0;
+
+        // top row is MAX_FREQ, bottom row MIN_FREQ, the scope points are already spaced the same way
+        spectrogramRowToScope.resize((size_t)spectrogram.getHeight());
+        for (int y = 0; y < spectrogram.getHeight(); ++y)
         {
-            auto bounds = getLocalBounds();
-            auto fftBounds = SpectrumAnalyzerUtils::getAnalysisArea(bounds).toFloat();
-            fftBounds.setBottom(bounds.getBottom());
-            analyzer.processFFT();
+            auto position = 1.0f - ((float)y + 0.5f) / (float)spectrogram.getHeight();
+            spectrogramRowToScope[(size_t)y] = juce::jlimit(0, FFTAnalyzer::scopeSize - 1, (int)std::round(position * (FFTAnalyzer::scopeSize - 1)));
         }
+
+        buildColumnMapping(area.getWidth());
+    }
+
+    void setDisplayMode(DisplayMode mode)
+    {
+        displayMode = mode;
+        showingSilence = false;
+        analyzer.setComparingInput(mode == DisplayMode::Difference);
+        analyzer.setQueueingSpectrogram(mode == DisplayMode::Spectrogram);
         repaint();
     }
 
-    juce::Path generateSpectrumPath(const float* data, size_t dataSize,
-                                     juce::Rectangle<int> bounds,
-                                     float minFreq = MIN_FREQ, float maxFreq = MAX_FREQ,
-                                     float minDB = MIN_DB, float maxDB = MAX_DB,
-                                     int smoothingPasses = 3)
+    // the filterbank modes feed the same scope, so both display modes work with them
+    void setAnalysisMode(FFTAnalyzer::AnalysisMode mode)
+    {
+        analyzer.setAnalysisMode(mode);
+    }
+
+    /*
+     Builds the curve for one scope into a path the caller keeps, so nothing here allocates once the path has grown.
+     The scope points are already log spaced like the display, so they map straight onto the pixel columns worked out
+     in resized(). Each column becomes its min and max after smoothing, which keeps the vertex count down to at most
+     two per pixel whatever the FFT size is.
+     */
+    void generateSpectrumPath(juce::Path& path, const float* data, juce::Rectangle<int> bounds,
+                              float minDB = MIN_DB, float maxDB = MAX_DB)
     {
-        juce::Path p;
-        auto width = bounds.getWidth();
+        path.clear();
+        auto numColumns = (int)columnFirstPoint.size() - 1;
+        if (numColumns <= 0)
+            return;
 
-        auto mapFreqToX = [=](float freq) {
-            float normX = std::log10(freq / minFreq) / std::log10(maxFreq / minFreq);
-            return normX * width;
-        };
+        smoothScope(data);
 
-        std::vector<float> smoothed(data, data + dataSize);
+        const auto* smoothed = smoothedPoints.data();
+        for (int column = 0; column < numColumns; ++column)
+        {
+            auto first = columnFirstPoint[(size_t)column];
+            auto count = columnFirstPoint[(size_t)column + 1] - first;
+            if (count <= 0)
+                continue;
+
+            auto range = juce::FloatVectorOperations::findMinAndMax(smoothed + first, count);
+            columnMin[(size_t)column] = range.getStart();
+            columnMax[(size_t)column] = range.getEnd();
+        }
 
-        for (int pass = 0; pass < smoothingPasses; ++pass)
+        // dB to y for every column at once
+        auto yScale = -(float)bounds.getHeight() / (maxDB - minDB);
+        auto yOffset = (float)bounds.getBottom() - minDB * yScale;
+        for (auto* envelope : { columnMin.data(), columnMax.data() })
         {
-            std::vector<float> temp(smoothed);
-            for (size_t i = 1; i < dataSize - 1; ++i)
-            {
-                smoothed[i] = (temp[i - 1] + temp[i] + temp[i + 1]) / 3.0f;
-            }
+            juce::FloatVectorOperations::clip(envelope, envelope, minDB, maxDB, numColumns);
+            juce::FloatVectorOperations::multiply(envelope, yScale, numColumns);
+            juce::FloatVectorOperations::add(envelope, yOffset, numColumns);
         }
 
         bool started = false;
-        for (size_t i = 0; i < dataSize; ++i)
+        float previousY = 0.0f;
+        for (int column = 0; column < numColumns; ++column)
         {
-            float normPos = (float)i / (float)(dataSize - 1);
-            float freq = std::pow(10.0f, normPos * (std::log10(maxFreq) - std::log10(minFreq)) + std::log10(minFreq));
-            float x = mapFreqToX(freq);
+            if (columnFirstPoint[(size_t)column + 1] == columnFirstPoint[(size_t)column])
+                continue;
+
+            auto x = (float)(bounds.getX() + column) + 0.5f;
+            auto top = columnMax[(size_t)column];
+            auto bottom = columnMin[(size_t)column];
 
-            float dB = juce::jlimit(minDB, maxDB, smoothed[i]);
-            float y = juce::jmap(dB, minDB, maxDB, (float)bounds.getBottom(), (float)bounds.getY());
+            // come in at whichever end is nearer the last column so the line doesn't zig-zag
+            auto enter = !started || std::abs(top - previousY) <= std::abs(bottom - previousY) ? top : bottom;
+            auto leave = enter == top ? bottom : top;
 
             if (!started)
             {
-                p.startNewSubPath(x, y);
+                path.startNewSubPath(x, enter);
                 started = true;
             }
             else
             {
-                p.lineTo(x, y);
+                path.lineTo(x, enter);
             }
-        }
 
-        return p;
+            if (leave != enter)
+                path.lineTo(x, leave);
+
+            previousY = leave;
+        }
     }
     
     float dBtoY(float dB) const
@@ -159,11 +247,25 @@ public:
     {
         auto localBounds = getLocalBounds();
         auto analysisArea = SpectrumAnalyzerUtils::getAnalysisArea(localBounds);
-        g.setColour(TSPalette::getAnalysisAreaBackgroundColor());
-        g.fillRect(analysisArea);
         auto bounds = getModuleBackgroundArea(localBounds);
-        drawGridAndLabels(g, bounds);
+        // the grid belongs to the line display, the spectrogram's axes are time and frequency
+        if (displayMode == DisplayMode::Spectrogram)
+        {
+            g.setColour(TSPalette::getAnalysisAreaBackgroundColor());
+            g.fillRect(analysisArea);
+            drawSpectrogram(g, bounds);
+            return;
+        }
+        // background, gridlines and labels only change with the size, so only the curves are drawn every frame
+        gridLayer.draw(g, localBounds, [this, analysisArea, bounds](juce::Graphics& layer)
+        {
+            layer.setColour(TSPalette::getAnalysisAreaBackgroundColor());
+            layer.fillRect(analysisArea);
+            drawGridAndLabels(layer, bounds);
+        });
         drawSpectrum(g, bounds);
+        if (displayMode == DisplayMode::Difference)
+            drawDifference(g, bounds);
     }
 
     void drawGridAndLabels(juce::Graphics& g, juce::Rectangle<int> bounds)
@@ -235,11 +337,8 @@ public:
         const auto* left = analyzer.getScopeData(0);
         const auto* right = analyzer.getScopeData(1);
 
-        auto leftPath = generateSpectrumPath(left, FFTAnalyzer::scopeSize, responseArea);
-        auto rightPath = generateSpectrumPath(right, FFTAnalyzer::scopeSize, responseArea);
-        
-        leftPath.applyTransform(juce::AffineTransform().translation(responseArea.getX(), 0));
-        rightPath.applyTransform(juce::AffineTransform().translation(responseArea.getX(), 0));
+        generateSpectrumPath(leftPath, left, responseArea);
+        generateSpectrumPath(rightPath, right, responseArea);
 
         g.setColour(TSPalette::getLeftChannelColor());
         g.strokePath(leftPath, juce::PathStrokeType(1.5f, juce::PathStrokeType::curved));
@@ -248,13 +347,166 @@ public:
         g.strokePath(rightPath, juce::PathStrokeType(1.5f, juce::PathStrokeType::curved));
     }
     
+    /*
+     The history is a ring: the newest column sits at spectrogramColumn - 1, so the oldest part is drawn first,
+     from spectrogramColumn to the right edge, and the newer part after it. Nothing in the image gets redrawn.
+     */
+    void drawSpectrogram(juce::Graphics& g, juce::Rectangle<int> bounds)
+    {
+        if (spectrogram.isNull())
+            return;
+
+        auto area = SpectrumAnalyzerUtils::getAnalysisArea(bounds);
+        auto width = spectrogram.getWidth();
+        auto height = spectrogram.getHeight();
+        auto olderWidth = width - spectrogramColumn;
+
+        g.drawImage(spectrogram, area.getX(), area.getY(), olderWidth, area.getHeight(),
+                    spectrogramColumn, 0, olderWidth, height);
+        if (spectrogramColumn > 0)
+            g.drawImage(spectrogram, area.getX() + olderWidth, area.getY(), spectrogramColumn, area.getHeight(),
+                        0, 0, spectrogramColumn, height);
+    }
+
+    /*
+     The dry input in the channel colours but faint, and what the processing added on top as one curve,
+     output minus input averaged over both channels, with 0 dB in the middle of the area.
+     */
+    void drawDifference(juce::Graphics& g, juce::Rectangle<int> bounds)
+    {
+        const auto* inputLeft = analyzer.getInputScopeData(0);
+        const auto* inputRight = analyzer.getInputScopeData(1);
+        if (inputLeft == nullptr || inputRight == nullptr)
+            return;
+
+        auto responseArea = SpectrumAnalyzerUtils::getAnalysisArea(bounds);
+        juce::Graphics::ScopedSaveState sss(g);
+        g.reduceClipRegion(responseArea);
+
+        generateSpectrumPath(inputLeftPath, inputLeft, responseArea);
+        generateSpectrumPath(inputRightPath, inputRight, responseArea);
+
+        g.setColour(TSPalette::getLeftChannelColor().withAlpha(0.35f));
+        g.strokePath(inputLeftPath, juce::PathStrokeType(1.0f));
+        g.setColour(TSPalette::getRightChannelColor().withAlpha(0.35f));
+        g.strokePath(inputRightPath, juce::PathStrokeType(1.0f));
+
+        const auto* outputLeft = analyzer.getScopeData(0);
+        const auto* outputRight = analyzer.getScopeData(1);
+        auto* diff = difference.data();
+        juce::FloatVectorOperations::subtract(diff, outputLeft, inputLeft, FFTAnalyzer::scopeSize);
+        juce::FloatVectorOperations::add(diff, outputRight, FFTAnalyzer::scopeSize);
+        juce::FloatVectorOperations::subtract(diff, inputRight, FFTAnalyzer::scopeSize);
+        juce::FloatVectorOperations::multiply(diff, 0.5f, FFTAnalyzer::scopeSize);
+
+        generateSpectrumPath(differencePath, diff, responseArea, -differenceRangeDB, differenceRangeDB);
+
+        g.setColour(TSPalette::getGridlineColor().withAlpha(0.5f));
+        g.drawHorizontalLine(responseArea.getCentreY(), (float)responseArea.getX(), (float)responseArea.getRight());
+        g.setColour(TSPalette::getDifferenceCurveColor());
+        g.strokePath(differencePath, juce::PathStrokeType(2.0f, juce::PathStrokeType::curved));
+    }
+
     void toggleAnalysisEnablement(bool enabled)
     {
         shouldShowFFTAnalysis = enabled;
+        analyzer.setPaused(!enabled);
+        repaint();
     }
 private:
+    juce::Rectangle<int> getSpectrumArea() const
+    {
+        return SpectrumAnalyzerUtils::getAnalysisArea(getModuleBackgroundArea(getLocalBounds()));
+    }
+
+    bool isScopeSilent() const
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            if (juce::FloatVectorOperations::findMinAndMax(analyzer.getScopeData(channel), FFTAnalyzer::scopeSize).getEnd() > MIN_DB)
+                return false;
+
+        return true;
+    }
+
+    // scope point i sits at i / (scopeSize - 1) of the width, so column c starts at the first point at or past it
+    void buildColumnMapping(int width)
+    {
+        auto numColumns = juce::jmax(0, width);
+        columnFirstPoint.resize((size_t)numColumns + 1);
+        for (int column = 0; column <= numColumns; ++column)
+        {
+            auto first = (int)std::ceil((double)column * (FFTAnalyzer::scopeSize - 1) / (double)juce::jmax(1, numColumns));
+            columnFirstPoint[(size_t)column] = juce::jlimit(0, FFTAnalyzer::scopeSize, first);
+        }
+        // the last point lands exactly on the right edge, it belongs to the last column
+        columnFirstPoint.back() = FFTAnalyzer::scopeSize;
+
+        columnMin.assign((size_t)numColumns, 0.0f);
+        columnMax.assign((size_t)numColumns, 0.0f);
+        for (auto* path : { &leftPath, &rightPath, &inputLeftPath, &inputRightPath, &differencePath })
+            path->preallocateSpace(numColumns * 6 + 8);
+    }
+
+    /*
+     Three passes of a 3 point average are the same as one pass of a 7 tap [1 3 6 7 6 3 1] / 27 kernel,
+     so it runs as seven multiply-adds over the whole scope. The three points at either end are left as they are.
+     */
+    void smoothScope(const float* data)
+    {
+        static constexpr float kernel[] { 1.f / 27.f, 3.f / 27.f, 6.f / 27.f, 7.f / 27.f, 6.f / 27.f, 3.f / 27.f, 1.f / 27.f };
+        constexpr int reach = 3;
+        constexpr int inner = FFTAnalyzer::scopeSize - 2 * reach;
+        auto* smoothed = smoothedPoints.data();
+
+        juce::FloatVectorOperations::copyWithMultiply(smoothed + reach, data + reach, kernel[reach], inner);
+        for (int tap = 0; tap < 2 * reach + 1; ++tap)
+            if (tap != reach)
+                juce::FloatVectorOperations::addWithMultiply(smoothed + reach, data + tap, kernel[tap], inner);
+
+        std::copy(data, data + reach, smoothed);
+        std::copy(data + FFTAnalyzer::scopeSize - reach, data + FFTAnalyzer::scopeSize, smoothed + FFTAnalyzer::scopeSize - reach);
+    }
+
+    // the analyzer already picked the louder channel, so a one sided signal still shows up, and scaled it to the colour map
+    void addSpectrogramColumn(const juce::uint8* levels)
+    {
+        if (spectrogram.isNull())
+            return;
+
+        juce::Image::BitmapData pixels(spectrogram, spectrogramColumn, 0, 1, spectrogram.getHeight(), juce::Image::BitmapData::writeOnly);
+        for (int y = 0; y < pixels.height; ++y)
+            pixels.setPixelColour(0, y, spectrogramColourMap[levels[spectrogramRowToScope[(size_t)y]]]);
+
+        spectrogramColumn = (spectrogramColumn + 1) % spectrogram.getWidth();
+    }
+
+    void buildSpectrogramColourMap()
+    {
+        juce::ColourGradient gradient(TSPalette::getAnalysisAreaBackgroundColor(), 0.0f, 0.0f,
+                                      juce::Colours::white, 1.0f, 0.0f, false);
+        gradient.addColour(0.4, TSPalette::getRightChannelColor());
+        gradient.addColour(0.75, TSPalette::getLeftChannelColor());
+
+        for (size_t i = 0; i < spectrogramColourMap.size(); ++i)
+            spectrogramColourMap[i] = gradient.getColourAtPosition((double)i / (double)(spectrogramColourMap.size() - 1));
+    }
+
     FFTAnalyzer& analyzer;
     bool shouldShowFFTAnalysis = true;
+    bool showingSilence = false;
+    CachedLayer gridLayer;
+    DisplayMode displayMode = DisplayMode::Spectrum;
+    static constexpr float differenceRangeDB = 24.0f;
+    // sized once, the scope buffers here and the column buffers and paths in resized()
+    std::vector<float> difference = std::vector<float>(FFTAnalyzer::scopeSize);
+    std::vector<float> smoothedPoints = std::vector<float>(FFTAnalyzer::scopeSize);
+    std::vector<int> columnFirstPoint;
+    std::vector<float> columnMin, columnMax;
+    juce::Path leftPath, rightPath, inputLeftPath, inputRightPath, differencePath;
+    juce::Image spectrogram;
+    int spectrogramColumn = 0;
+    std::vector<int> spectrogramRowToScope;
+    std::array<juce::Colour, 256> spectrogramColourMap;
     const std::vector<float> freqs { 20.f, 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f, 20000.f };
     const std::vector<float> gains { -36.f, -24.f, -12.f, 0.f, 12.f };
     const std::vector<juce::String> hertz
@@ -10,10 +10,52 @@
 #include "PluginEditor.h"
 #include "./GUI/RotaryKnob.hpp"
 #include "./GUI/KnobPanel.hpp"
+#include "./DSP/Params.h"
 
-HeaderBar::HeaderBar()
+// one line of the settings menu's diagnostics, e.g. "Prepare: 1.20 ms last, 0.85 ms average over 4"
+static juce::String describeTiming (const juce::String& name, const TimingStatistic& timing)
 {
+    if (timing.getNumMeasurements() == 0)
+        return name + ": not measured yet";
+    
+    return name + ": " + juce::String(timing.getLastMicroseconds() / 1000.0, 2) + " ms last, "
+        + juce::String(timing.getAverageMicroseconds() / 1000.0, 2) + " ms average over "
+        + juce::String(timing.getNumMeasurements());
+}
+
+HeaderBar::HeaderBar(juce::AudioProcessorValueTreeState& apvts)
+{
+    // decoded once, and shared by every open editor
+    title = SharedResources::get<juce::Image>("image/logo", []
+    {
+        return std::make_shared<const juce::Image>(juce::ImageCache::getFromMemory(BinaryData::tSaturator_logo_jpg, BinaryData::tSaturator_logo_jpgSize));
+    });
+    
     addAndMakeVisible(analyzerToggleButton);
+    
+    // the boxes need their items before the attachments push the current value into them
+    auto attachChoice = [&apvts](juce::ComboBox& box, const juce::String& paramID)
+    {
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(paramID)))
+            box.addItemList(choice->choices, 1);
+        
+        return std::make_unique<Attachment>(apvts, paramID, box);
+    };
+    
+    drivePositionAttachment = attachChoice(drivePositionBox, Params::DRIVE_POSITION);
+    hissPositionAttachment = attachChoice(hissPositionBox, Params::HISS_POSITION);
+    addAndMakeVisible(drivePositionBox);
+    addAndMakeVisible(hissPositionBox);
+    
+    analyzerModeBox.addItemList({ "Spectrum", "1/3 Octave", "1/6 Octave", "Spectrogram", "In/Out Difference" }, 1);
+    analyzerModeBox.setSelectedId(1, juce::dontSendNotification);
+    addAndMakeVisible(analyzerModeBox);
+    
+    qualityLabel.setText(QualityGovernor::getTierName(QualityTier::Full), juce::dontSendNotification);
+    qualityLabel.setJustificationType(juce::Justification::centredLeft);
+    qualityLabel.setFont(juce::Font(juce::FontOptions(12.0f)));
+    addAndMakeVisible(qualityLabel);
+    addAndMakeVisible(settingsButton);
 }
 
 void HeaderBar::resized()
@@ -24,30 +66,54 @@ void HeaderBar::resized()
                              .withTrimmedTop(20)
                              .withTrimmedLeft(20)
                              .withTrimmedBottom(20));
+    drivePositionBox.setBounds(bounds.removeFromLeft(140)
+                               .withTrimmedTop(20)
+                               .withTrimmedLeft(20)
+                               .withTrimmedBottom(20));
+    hissPositionBox.setBounds(bounds.removeFromLeft(160)
+                              .withTrimmedTop(20)
+                              .withTrimmedLeft(20)
+                              .withTrimmedBottom(20));
+    // these sit in the gap under the controls, the right half belongs to the logo
+    auto strip = getLocalBounds().removeFromBottom(20).removeFromLeft(420);
+    qualityLabel.setBounds(strip.removeFromLeft(150)
+                           .withTrimmedLeft(20));
+    analyzerModeBox.setBounds(strip.removeFromLeft(170)
+                              .withTrimmedLeft(20)
+                              .withTrimmedBottom(2));
+    settingsButton.setBounds(strip.withTrimmedLeft(20)
+                             .withTrimmedBottom(2));
 }
 
 void HeaderBar::paint(juce::Graphics& g)
 {
+    // the logo is only scaled down again when the header's size or the display scale changes
     auto bounds = getLocalBounds();
-    juce::Rectangle<float> titleBox;
-    titleBox.setHeight(bounds.getHeight());
-    titleBox.setWidth(bounds.getWidth() / 3);
-    titleBox.setX(bounds.getCentreX() + 5);
-    titleBox.setRight(bounds.getRight() - 50);
-    g.setColour(TSPalette::getAnalysisAreaBackgroundColor());
-    g.fillAll();
-    title = juce::ImageCache::getFromMemory(BinaryData::tSaturator_logo_jpg, BinaryData::tSaturator_logo_jpgSize);
-    g.drawImage(title, titleBox);
+    background.draw(g, bounds, [this, bounds](juce::Graphics& layer)
+    {
+        juce::Rectangle<float> titleBox;
+        titleBox.setHeight(bounds.getHeight());
+        titleBox.setWidth(bounds.getWidth() / 3);
+        titleBox.setX(bounds.getCentreX() + 5);
+        titleBox.setRight(bounds.getRight() - 50);
+        layer.setColour(TSPalette::getAnalysisAreaBackgroundColor());
+        layer.fillAll();
+        layer.drawImage(*title, titleBox);
+    });
 }
 
 //==============================================================================
 TapeSaturationAudioProcessorEditor::TapeSaturationAudioProcessorEditor (TapeSaturationAudioProcessor& p)
-: AudioProcessorEditor(&p), audioProcessor (p), analyzer (p.analyzer)
+: AudioProcessorEditor(&p), audioProcessor (p), analyzer (p.analyzer),
+inputMeter (p.inputMeter, "IN"), outputMeter (p.outputMeter, "OUT"), goniometer (p.stereoScope)
 {
     setLookAndFeel(&lnf);
     
     addAndMakeVisible(headerBar);
     addAndMakeVisible(analyzer);
+    addAndMakeVisible(inputMeter);
+    addAndMakeVisible(outputMeter);
+    addAndMakeVisible(goniometer);
     addAndMakeVisible(knobPanel);
     
     auto safePtr = juce::Component::SafePointer<TapeSaturationAudioProcessorEditor>(this);
@@ -61,10 +127,35 @@ TapeSaturationAudioProcessorEditor::TapeSaturationAudioProcessorEditor (TapeSatu
         }
     };
     
+    headerBar.analyzerModeBox.onChange = [safePtr]()
+    {
+        if (auto* comp = safePtr.getComponent())
+        {
+            using Mode = FFTAnalyzer::AnalysisMode;
+            auto id = comp->headerBar.analyzerModeBox.getSelectedId();
+            comp->analyzer.setAnalysisMode(id == 2 ? Mode::ThirdOctave : id == 3 ? Mode::SixthOctave : Mode::FFT);
+            comp->analyzer.setDisplayMode(id == 4 ? SpectrumAnalyzer::DisplayMode::Spectrogram
+                                        : id == 5 ? SpectrumAnalyzer::DisplayMode::Difference
+                                                  : SpectrumAnalyzer::DisplayMode::Spectrum);
+        }
+    };
+    
+    headerBar.settingsButton.onClick = [safePtr]()
+    {
+        if (auto* comp = safePtr.getComponent())
+            comp->showSettingsMenu();
+    };
+    
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
     setSize(850, 600);
-    startTimerHz(60);
+    
+    // one vblank driven clock for everything that moves, each part only repaints itself when its data changed
+    scheduler.addClient(analyzer, 60.0);
+    scheduler.addClient(goniometer, 60.0);
+    scheduler.addClient(inputMeter, LevelMeterDisplay::refreshRateHz);
+    scheduler.addClient(outputMeter, LevelMeterDisplay::refreshRateHz);
+    scheduler.addClient(*this, 4.0);
 }
 
 TapeSaturationAudioProcessorEditor::~TapeSaturationAudioProcessorEditor()
@@ -88,11 +179,94 @@ void TapeSaturationAudioProcessorEditor::resized()
     auto bounds = getLocalBounds();
     
     headerBar.setBounds(bounds.removeFromTop(75));
-    analyzer.setBounds(bounds.removeFromTop(225));
+    // the meters sit either side of the analyzer, input on the left and output on the right,
+    // with the goniometer between the analyzer and the output meter
+    auto analyzerRow = bounds.removeFromTop(225);
+    inputMeter.setBounds(analyzerRow.removeFromLeft(60));
+    outputMeter.setBounds(analyzerRow.removeFromRight(60));
+    goniometer.setBounds(analyzerRow.removeFromRight(190));
+    analyzer.setBounds(analyzerRow);
     knobPanel.setBounds(bounds.removeFromBottom(300));
 }
 
-void TapeSaturationAudioProcessorEditor::timerCallback()
+void TapeSaturationAudioProcessorEditor::showSettingsMenu()
 {
-    analyzer.timerCallback();
+    // the items only talk to the processor, which outlives the menu
+    auto& processor = audioProcessor;
+    juce::PopupMenu menu;
+    
+    menu.addSectionHeader("Tile size");
+    for (auto tileSize : { 32, 64, 128 })
+        menu.addItem(juce::String(tileSize) + " samples", true, processor.getTileSize() == tileSize,
+                     [&processor, tileSize] { processor.setTileSize(tileSize); });
+    
+    // the helpers only share out channel groups, so a stereo bus never uses them
+    if (auto maxThreads = TapeSaturationAudioProcessor::getMaxWorkerThreads(); maxThreads > 0)
+    {
+        menu.addSectionHeader("Helper threads (wider than stereo)");
+        for (int numThreads = 0; numThreads <= maxThreads; ++numThreads)
+            menu.addItem(numThreads == 0 ? juce::String("Off") : juce::String(numThreads), true,
+                         processor.getNumWorkerThreads() == numThreads,
+                         [&processor, numThreads] { processor.setNumWorkerThreads(numThreads); });
+    }
+    
+    menu.addSectionHeader("Latency");
+    menu.addItem("Run the saturation a block ahead", true, processor.isPipelined(),
+                 [&processor] { processor.setPipelined(!processor.isPipelined()); });
+    
+    // the analyzer lives in the processor, so these stay as they were when the editor is reopened
+    auto& analyzer = processor.analyzer;
+    menu.addSectionHeader("Analyzer");
+    
+    juce::PopupMenu sizeMenu;
+    sizeMenu.addItem("Auto", true, analyzer.getFFTOrder() == FFTAnalyzer::automaticFFTOrder,
+                     [&analyzer] { analyzer.setFFTOrder(FFTAnalyzer::automaticFFTOrder); });
+    for (int order = FFTAnalyzer::minFFTOrder; order <= FFTAnalyzer::maxFFTOrder; ++order)
+        sizeMenu.addItem(juce::String(1 << order) + " points", true, analyzer.getFFTOrder() == order,
+                         [&analyzer, order] { analyzer.setFFTOrder(order); });
+    menu.addSubMenu("FFT size", sizeMenu);
+    
+    juce::PopupMenu overlapMenu;
+    for (auto overlap : { 0.0f, 0.5f, 0.75f, FFTAnalyzer::maxOverlap })
+        overlapMenu.addItem(juce::String(overlap * 100.0f, overlap == FFTAnalyzer::maxOverlap ? 1 : 0) + "%", true,
+                            analyzer.getOverlap() == overlap,
+                            [&analyzer, overlap] { analyzer.setOverlap(overlap); });
+    menu.addSubMenu("Overlap", overlapMenu);
+    
+    using Window = FFTAnalyzer::WindowType;
+    juce::PopupMenu windowMenu;
+    for (auto [window, name] : { std::pair { Window::hann, "Hann" }, { Window::hamming, "Hamming" },
+                                 { Window::blackman, "Blackman" }, { Window::blackmanHarris, "Blackman-Harris" },
+                                 { Window::flatTop, "Flat top" }, { Window::rectangular, "Rectangular" } })
+        windowMenu.addItem(name, true, analyzer.getWindowType() == window,
+                           [&analyzer, window = window] { analyzer.setWindowType(window); });
+    menu.addSubMenu("Window", windowMenu);
+    
+    // the 1/3 and 1/6 octave modes only, the FFT has its own smoothing
+    using Ballistics = FFTAnalyzer::Ballistics;
+    juce::PopupMenu ballisticsMenu;
+    ballisticsMenu.addItem("RMS", true, analyzer.getBallistics() == Ballistics::Rms,
+                           [&analyzer] { analyzer.setBallistics(Ballistics::Rms); });
+    ballisticsMenu.addItem("Peak", true, analyzer.getBallistics() == Ballistics::Peak,
+                           [&analyzer] { analyzer.setBallistics(Ballistics::Peak); });
+    menu.addSubMenu("Octave band ballistics", ballisticsMenu);
+    
+    menu.addSectionHeader("Diagnostics");
+    menu.addItem(describeTiming("Prepare", processor.getPrepareTiming()), false, false, nullptr);
+    menu.addItem(describeTiming("Save state", processor.getSaveTiming()), false, false, nullptr);
+    menu.addItem(describeTiming("Load state", processor.getLoadTiming()), false, false, nullptr);
+    menu.addItem(describeTiming("Editor frame", getFrameTiming()), false, false, nullptr);
+    
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&headerBar.settingsButton));
+}
+
+bool TapeSaturationAudioProcessorEditor::renderFrame()
+{
+    auto tier = audioProcessor.getQualityTier();
+    if (tier == shownQualityTier)
+        return false;
+    
+    shownQualityTier = tier;
+    headerBar.qualityLabel.setText(QualityGovernor::getTierName(tier), juce::dontSendNotification);
+    return true;
 }
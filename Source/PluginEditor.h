@@ -14,24 +14,36 @@
 #include "./GUI/LookAndFeel.hpp"
 #include "./GUI/SpectrumAnalyzer.hpp"
 #include "./GUI/KnobPanel.hpp"
+#include "./GUI/LevelMeterDisplay.hpp"
+#include "./GUI/Goniometer.hpp"
+#include "./GUI/CachedLayer.hpp"
+#include "./GUI/RenderScheduler.hpp"
 
 /*
- Holds title and analyzer toggle button
+ Holds title, analyzer toggle button and mode selector, the stage order selectors, and the settings menu button
  */
 struct HeaderBar : juce::Component
 {
-    HeaderBar();
+    HeaderBar(juce::AudioProcessorValueTreeState& apvts);
     void resized() override;
     void paint(juce::Graphics& g) override;
     
     juce::ToggleButton analyzerToggleButton;
-    juce::Image title;
+    juce::ComboBox drivePositionBox, hissPositionBox;
+    juce::ComboBox analyzerModeBox;
+    juce::Label qualityLabel;
+    juce::TextButton settingsButton { "Settings" };
+    SharedResources::Ptr<juce::Image> title;
+private:
+    using Attachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+    std::unique_ptr<Attachment> drivePositionAttachment, hissPositionAttachment;
+    CachedLayer background;
 };
 
 //==============================================================================
 /**
 */
-class TapeSaturationAudioProcessorEditor : public juce::AudioProcessorEditor, juce::Timer
+class TapeSaturationAudioProcessorEditor : public juce::AudioProcessorEditor, private RenderScheduler::Client
 {
 public:
     TapeSaturationAudioProcessorEditor (TapeSaturationAudioProcessor&);
@@ -41,16 +53,25 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     
-    void timerCallback() override;
+    // how long the scheduler's frames take, shown under Diagnostics in the settings menu
+    const TimingStatistic& getFrameTiming() const { return scheduler.getFrameTiming(); }
 private:
+    bool renderFrame() override;
+    // the settings that aren't parameters, so the host doesn't show or automate them
+    void showSettingsMenu();
+    
     LookAndFeel lnf;
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     TapeSaturationAudioProcessor& audioProcessor;
     
-    HeaderBar headerBar;
+    HeaderBar headerBar { audioProcessor.apvts };
+    QualityTier shownQualityTier { QualityTier::Full };
     KnobPanel knobPanel { audioProcessor.apvts };
     SpectrumAnalyzer analyzer;
+    LevelMeterDisplay inputMeter, outputMeter;
+    Goniometer goniometer;
+    RenderScheduler scheduler { *this };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapeSaturationAudioProcessorEditor)
 };
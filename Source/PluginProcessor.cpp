@@ -20,6 +20,8 @@ AudioProcessor (BusesProperties()
                 .withOutput ("Output", juce::AudioChannelSet::stereo(), true)),
 apvts {*this, nullptr, juce::Identifier("Controls"), createParameterLayout()}
 {
+    drivePosition = apvts.getRawParameterValue(Params::DRIVE_POSITION);
+    hissPosition = apvts.getRawParameterValue(Params::HISS_POSITION);
 }
 
 TapeSaturationAudioProcessor::~TapeSaturationAudioProcessor()
@@ -93,22 +95,49 @@ void TapeSaturationAudioProcessor::prepareToPlay (double sampleRate, int samples
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    juce::dsp::ProcessSpec spec;
-    
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 2;
-    spec.sampleRate = sampleRate;
+    {
+        ScopedTimingMeasurement measurement(prepareTiming);
+        juce::dsp::ProcessSpec spec;
+        
+        spec.maximumBlockSize = samplesPerBlock;
+        spec.numChannels = (juce::uint32)getMainBusNumOutputChannels();
+        spec.sampleRate = sampleRate;
+        
+        // the threads are only (re)spawned when the requested count changes,
+        // the pipeline needs at least one to run the front of the chain on
+        auto pipelined = pipelineRequested.load();
+        auto numWorkers = juce::jmax(requestedWorkerThreads.load(), pipelined ? 1 : 0);
+        if (numWorkers != (workerPool == nullptr ? 0 : workerPool->getNumWorkers()))
+        {
+            workerPool.reset();
+            if (numWorkers > 0)
+                workerPool = std::make_unique<WorkerPool>(numWorkers);
+        }
+        
+        floatChain.setPipelined(pipelined);
+        doubleChain.setPipelined(pipelined);
+        floatChain.setTileSize(requestedTileSize.load());
+        doubleChain.setTileSize(requestedTileSize.load());
+        
+        // only the chain matching the host's precision gets allocated
+        auto latency = isUsingDoublePrecision() ? doubleChain.prepare(spec, workerPool.get())
+                                                : floatChain.prepare(spec, workerPool.get());
+        setLatencySamples(latency);
+        governor.prepare(sampleRate);
+        analyzer.prepare(sampleRate, latency);
+        inputMeter.prepare(sampleRate, samplesPerBlock);
+        outputMeter.prepare(sampleRate, samplesPerBlock);
+        stereoScope.prepare(sampleRate);
+    }
     
-    dp.prepare(spec);
-    sp.prepare(spec);
-    hp.prepare(spec);
-    mp.prepare(spec);
+    prepared.store(true);
 }
 
 void TapeSaturationAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    prepared.store(false);
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -118,12 +147,14 @@ bool TapeSaturationAudioProcessor::isBusesLayoutSupported (const BusesLayout& la
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Anything from mono up to 7.1.4 is supported, each channel count gets its own
+    // specialised processing path (see ChannelDispatch.h).
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    auto numOutputChannels = layouts.getMainOutputChannelSet().size();
+    if (layouts.getMainOutputChannelSet().isDisabled()
+     || numOutputChannels < 1
+     || numOutputChannels > maxSupportedChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -138,8 +169,58 @@ bool TapeSaturationAudioProcessor::isBusesLayoutSupported (const BusesLayout& la
 #endif
 
 void TapeSaturationAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, floatChain);
+}
+
+void TapeSaturationAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples(buffer, doubleChain);
+}
+
+bool TapeSaturationAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void TapeSaturationAudioProcessor::setTileSize (int newTileSize)
+{
+    newTileSize = juce::jlimit(minTileSize, maxTileSize, newTileSize);
+    if (requestedTileSize.exchange(newTileSize) != newTileSize)
+        reprepare();
+}
+
+void TapeSaturationAudioProcessor::setNumWorkerThreads (int numThreads)
+{
+    numThreads = juce::jlimit(0, getMaxWorkerThreads(), numThreads);
+    if (requestedWorkerThreads.exchange(numThreads) != numThreads)
+        reprepare();
+}
+
+int TapeSaturationAudioProcessor::getMaxWorkerThreads()
+{
+    auto spareCores = juce::jmax(0, juce::SystemStats::getNumCpus() - 1);
+    return juce::jmin(spareCores, GroupedTapeChain<float>::maxGroups - 1);
+}
+
+void TapeSaturationAudioProcessor::setPipelined (bool shouldPipeline)
+{
+    if (pipelineRequested.exchange(shouldPipeline) != shouldPipeline)
+        reprepare();
+}
+
+template <typename SampleType>
+void TapeSaturationAudioProcessor::processSamples (juce::AudioBuffer<SampleType>& buffer, GroupedTapeChain<SampleType>& chain)
 {
     juce::ScopedNoDenormals noDenormals;
+    auto startTicks = juce::Time::getHighResolutionTicks();
+    
+    // the tier is decided from the previous blocks, each stage fades into it on its own
+    governor.setEnabled(!isNonRealtime());
+    auto tier = governor.getCurrentTier();
+    chain.setQualityTier(tier);
+    analyzer.setFrameDecimation(tier >= QualityTier::DecimatedAnalyzer ? 4 : 1);
+    
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -150,35 +231,92 @@ void TapeSaturationAudioProcessor::processBlock (juce::AudioBuffer<float>& buffe
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    auto block = juce::dsp::AudioBlock<float>(buffer);
+    auto* chL = buffer.getReadPointer(0);
+    auto* chR = buffer.getNumChannels() > 1 ? buffer.getReadPointer(1) : chL;
     
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
-    auto inBlock = context.getInputBlock();
+    // only does anything while the editor compares input and output
+    analyzer.pushInputSamples(chL, chR, buffer.getNumSamples());
+    inputMeter.process(chL, chR, buffer.getNumSamples());
     
-    mp.setDryBlock(inBlock);
-    dp.process(context);
-    sp.process(context);
-    hp.process(context);
-    mp.process(context);
+    auto block = juce::dsp::AudioBlock<SampleType>(buffer);
     
-    auto outBlock = context.getOutputBlock();
-    juce::AudioBuffer<float> outBuf;
+    auto context = juce::dsp::ProcessContextReplacing<SampleType>(block);
     
-    outBuf.setSize((int)outBlock.getNumChannels(), (int)outBlock.getNumSamples(), false, false, true);
-    // Copy output samples into the storage buffer
-    for (size_t ch = 0; ch < outBlock.getNumChannels(); ++ch)
-    {
-        outBuf.copyFrom((int)ch, 0, outBlock.getChannelPointer(ch), (int)outBlock.getNumSamples());
-    }
+    // the stage order is only looked at once per block, everything below it is inlined
+    // and then run tile by tile, with one channel group per thread on wide buses
+    chain.process(getCurrentStageOrder(), context);
     
-    auto* chL = outBuf.getReadPointer(0);
-    auto* chR = outBuf.getNumChannels() > 1 ? outBuf.getReadPointer(1) : chL;
+    analyzer.pushSamples(chL, chR, buffer.getNumSamples());
+    outputMeter.process(chL, chR, buffer.getNumSamples());
+    stereoScope.process(chL, chR, buffer.getNumSamples());
+    
+    auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    governor.update(elapsed, buffer.getNumSamples());
+}
+
+StageOrder TapeSaturationAudioProcessor::getCurrentStageOrder() const
+{
+    return getStageOrder(drivePosition->load() > 0.5f, hissPosition->load() > 0.5f);
+}
 
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
+BinaryState::Settings TapeSaturationAudioProcessor::getSettings() const
+{
+    return {
+        { "tileSize", (float)getTileSize() },
+        { "workerThreads", (float)getNumWorkerThreads() },
+        { "pipelined", isPipelined() ? 1.f : 0.f },
+        { "fftOrder", (float)analyzer.getFFTOrder() },
+        { "fftOverlap", analyzer.getOverlap() },
+        { "fftWindow", (float)analyzer.getWindowType() },
+        { "analyzerBallistics", (float)analyzer.getBallistics() }
+    };
+}
+
+void TapeSaturationAudioProcessor::applySettings (const BinaryState::Settings& settings)
+{
+    // only a setting that actually changes costs a re-prepare, loading a session like the current one costs nothing
+    auto needsPrepare = false;
+    auto update = [&needsPrepare] (auto& setting, auto newValue)
     {
-        analyzer.pushSample(0, chL[i]);
-        analyzer.pushSample(1, chR[i]);
+        if (setting.exchange(newValue) != newValue)
+            needsPrepare = true;
+    };
+    
+    for (auto& [name, value] : settings)
+    {
+        if (name == "tileSize")
+            update(requestedTileSize, juce::jlimit(minTileSize, maxTileSize, juce::roundToInt(value)));
+        else if (name == "workerThreads")
+            update(requestedWorkerThreads, juce::jlimit(0, getMaxWorkerThreads(), juce::roundToInt(value)));
+        else if (name == "pipelined")
+            update(pipelineRequested, value > 0.5f);
+        // the analyzer picks these up on its own thread
+        else if (name == "fftOrder")
+            analyzer.setFFTOrder(juce::roundToInt(value));
+        else if (name == "fftOverlap")
+            analyzer.setOverlap(value);
+        else if (name == "fftWindow")
+            analyzer.setWindowType((FFTAnalyzer::WindowType)juce::jlimit(0, (int)FFTAnalyzer::WindowType::kaiser, juce::roundToInt(value)));
+        else if (name == "analyzerBallistics")
+            analyzer.setBallistics(value > 0.5f ? FFTAnalyzer::Ballistics::Peak : FFTAnalyzer::Ballistics::Rms);
     }
+    
+    if (needsPrepare)
+        reprepare();
+}
+
+void TapeSaturationAudioProcessor::reprepare()
+{
+    // nothing to do while the host has us released (or hasn't prepared us yet), its next prepareToPlay
+    // picks the settings up anyway
+    if (!prepared.load())
+        return;
+    
+    // a suspension the host asked for has to outlast this one
+    auto wasSuspended = isSuspended();
+    suspendProcessing(true);
+    prepareToPlay(getSampleRate(), getBlockSize());
+    suspendProcessing(wasSuspended);
 }
 
 //==============================================================================
@@ -199,20 +337,32 @@ void TapeSaturationAudioProcessor::getStateInformation (juce::MemoryBlock& destD
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
     
-    // save params upon close/open
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    // save params upon close/open, as plain values straight from the parameters
+    ScopedTimingMeasurement measurement(saveTiming);
+    BinaryState::write(getParameters(), getSettings(), destData);
 }
 
 void TapeSaturationAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
-    auto tree = juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes));
-    if (tree.isValid())
+    auto settings = getSettings();
     {
-        apvts.replaceState(tree);
+        ScopedTimingMeasurement measurement(loadTiming);
+        
+        // sessions saved before the binary format hold the APVTS ValueTree, and no settings
+        if (!BinaryState::read(data, sizeInBytes, getParameters(), settings))
+        {
+            auto tree = juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes));
+            if (tree.isValid())
+            {
+                apvts.replaceState(tree);
+            }
+        }
     }
+    
+    // outside the measurement, a changed setting re-prepares, which is timed on its own
+    applySettings(settings);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout TapeSaturationAudioProcessor::createParameterLayout()
@@ -236,6 +386,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout TapeSaturationAudioProcessor
                                                            Params::HISS,
                                                            juce::NormalisableRange<float>(0.f, 100.f, 1.f, 0.25f),
                                                            0.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(Params::DRIVE_POSITION, 5),
+                                                            Params::DRIVE_POSITION,
+                                                            juce::StringArray { "Pre-Curve", "Post-Curve" },
+                                                            0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID(Params::HISS_POSITION, 6),
+                                                            Params::HISS_POSITION,
+                                                            juce::StringArray { "Post-Saturation", "Pre-Saturation" },
+                                                            0));
     return layout;
 }
 //==============================================================================
@@ -14,7 +14,12 @@
 #include "./DSP/HissProcessor.h"
 #include "./DSP/MixProcessor.h"
 #include "./DSP/DriveProcessor.h"
+#include "./DSP/ProcessingGraph.h"
 #include "./DSP/FFTProcessing.h"
+#include "./DSP/LevelMeter.h"
+#include "./DSP/StereoScope.h"
+#include "./DSP/TimingStats.h"
+#include "./DSP/BinaryState.h"
 
 //==============================================================================
 /**
@@ -35,6 +40,33 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+    
+    // internal tile size in samples, clamped to 32-128. Saved with the session, and applied right away if already playing
+    void setTileSize (int newTileSize);
+    int getTileSize() const { return requestedTileSize.load(); }
+    
+    // opt-in helper threads for buses wider than stereo, 0 keeps everything on the host's thread.
+    // Clamped to getMaxWorkerThreads(), saved with the session, and applied right away if already playing
+    void setNumWorkerThreads (int numThreads);
+    int getNumWorkerThreads() const { return requestedWorkerThreads.load(); }
+    // one per spare core, and never more than there can be channel groups
+    static int getMaxWorkerThreads();
+    
+    // opt-in: runs the saturation a block ahead on a helper thread, for one extra block of latency.
+    // Saved with the session, and applied right away if already playing
+    void setPipelined (bool shouldPipeline);
+    bool isPipelined() const { return pipelineRequested.load(); }
+    
+    // how long this instance's prepareToPlay calls have taken, shown under Diagnostics in the settings menu
+    const TimingStatistic& getPrepareTiming() const { return prepareTiming; }
+    // and how long saving and restoring its state have taken, shown next to it
+    const TimingStatistic& getSaveTiming() const { return saveTiming; }
+    const TimingStatistic& getLoadTiming() const { return loadTiming; }
+    
+    // the tier the quality governor currently has the chain running at
+    QualityTier getQualityTier() const { return governor.getCurrentTier(); }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -66,13 +98,35 @@ public:
     
     using BlockType = juce::AudioBuffer<float>;
     
-    DriveProcessor dp {apvts};
-    SaturationProcessor sp {apvts};
-    HissProcessor hp {apvts};
-    MixProcessor mp {apvts};
+    GroupedTapeChain<float> floatChain {apvts};
+    GroupedTapeChain<double> doubleChain {apvts};
     FFTAnalyzer analyzer;
+    LevelMeter inputMeter, outputMeter;
+    StereoScope stereoScope;
 private:
-    int i;
+    StageOrder getCurrentStageOrder() const;
+    
+    // the settings that aren't parameters, as they're stored with the session
+    BinaryState::Settings getSettings() const;
+    void applySettings (const BinaryState::Settings& settings);
+    // runs prepareToPlay again with the current setup, so a changed setting takes effect without a transport restart
+    void reprepare();
+    
+    template <typename SampleType>
+    void processSamples (juce::AudioBuffer<SampleType>& buffer, GroupedTapeChain<SampleType>& chain);
+    
+    std::atomic<float>* drivePosition = nullptr;
+    std::atomic<float>* hissPosition = nullptr;
+    
+    TimingStatistic prepareTiming, saveTiming, loadTiming;
+    QualityGovernor governor;
+    
+    // between prepareToPlay and releaseResources, the only time reprepare() has anything to do
+    std::atomic<bool> prepared {false};
+    std::atomic<int> requestedTileSize {defaultTileSize};
+    std::atomic<int> requestedWorkerThreads {0};
+    std::atomic<bool> pipelineRequested {false};
+    std::unique_ptr<WorkerPool> workerPool;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapeSaturationAudioProcessor)
 };